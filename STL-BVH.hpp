@@ -0,0 +1,866 @@
+/*
+    STL-BVH, bounding volume hierarchy for STL-Parser and objectParser models
+    Copyright (C) 2026  STL-Parser contributors
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Author(s):
+        STL-Parser contributors
+
+    File Type: header/implementation, STL-BVH
+
+    Date Created: 10/18/2026
+
+    Date Last Modified: 10/18/2026
+
+    Purpose:
+        Spatial index over the triangles of an stl::Model or the quads of an objParse::Model
+        Used for ray picking (single rays or packets of 4 with SSE), closest point and box overlap queries
+        Tree is built with binned SAH, big subtrees are built on their own threads
+
+    Misc. Notes:
+        needs -std=c++11 -pthread, SSE packet traversal is used when __SSE__ is defined
+
+*/
+
+#ifndef __JJC_STL_BVH_HPP__
+#define __JJC_STL_BVH_HPP__
+
+#include <STL-Parser.hpp>
+
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <math.h>
+#include <float.h>
+
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif // __SSE__
+
+namespace stl {
+namespace bvh {
+
+    // tuning values for the builder
+    const int BVH_BINS = 16;            // SAH buckets per axis
+    const int BVH_MAX_LEAF = 4;         // leaves are always made at or below this many triangles
+    const int BVH_FORCE_LEAF = 16;      // leaves are allowed up to this size when splitting doesnt pay off
+    const int BVH_PARALLEL_SIZE = 8192; // subtrees smaller than this are built on the current thread
+    const int BVH_MAX_SAH_DEPTH = 64;   // below this depth nodes are split at the median to keep the tree shallow
+    const int BVH_STACK_SIZE = 128;
+
+    // one node of the flattened tree, 32 bytes so that two sit in every cache line
+    struct BVHNode {
+        GLfloat bmin[3];
+        GLfloat bmax[3];
+        int offset; // interior: index of right child (left child is always the next node), leaf: first triangle
+        int count;  // number of triangles in a leaf, 0 for interior nodes
+    };
+
+    struct BVHTri {
+        objParse::GLfloat3 pts[3];
+    };
+
+    struct BVH {
+        std::vector<BVHNode> nodes; // depth first order, nodes[0] is the root
+        std::vector<BVHTri> tris;   // triangles in leaf order
+        std::vector<int> primIds;   // facet index (stl) or quad index (objParse) for each triangle in tris
+    };
+
+    struct Ray {
+        objParse::GLfloat3 origin;
+        objParse::GLfloat3 dir; // does not need to be normalized, hit distances are in units of dir
+        GLfloat tMax;           // hits further away than this are ignored
+    };
+
+    struct Hit {
+        GLfloat t;
+        GLfloat u; // barycentric coordinates of the hit point
+        GLfloat v;
+        int prim;  // -1 when nothing was hit
+    };
+
+//-------------------------------------------------------------
+// building
+
+    // per-triangle information used only while building
+    struct BuildRef {
+        GLfloat bmin[3];
+        GLfloat bmax[3];
+        GLfloat centroid[3];
+        int tri;
+    };
+
+    struct BuildNode {
+        GLfloat bmin[3];
+        GLfloat bmax[3];
+        int start;
+        int count;
+        BuildNode* child[2];
+    };
+
+    GLfloat surfaceArea(const GLfloat bmin[3], const GLfloat bmax[3]) {
+        GLfloat dx = bmax[0] - bmin[0];
+        GLfloat dy = bmax[1] - bmin[1];
+        GLfloat dz = bmax[2] - bmin[2];
+        return 2.0f * (dx * dy + dy * dz + dz * dx);
+    }
+
+    void emptyBounds(GLfloat bmin[3], GLfloat bmax[3]) {
+        for(int i = 0; i < 3; i++) {
+            bmin[i] = FLT_MAX;
+            bmax[i] = -FLT_MAX;
+        }
+    }
+
+    void growBounds(GLfloat bmin[3], GLfloat bmax[3], const GLfloat omin[3], const GLfloat omax[3]) {
+        for(int i = 0; i < 3; i++) {
+            bmin[i] = std::min(bmin[i], omin[i]);
+            bmax[i] = std::max(bmax[i], omax[i]);
+        }
+    }
+
+    BuildNode* buildRecursive(BuildRef* refs, int start, int count, int depth, int threadDepth) {
+        BuildNode* node = new BuildNode;
+        node->start = start;
+        node->count = count;
+        node->child[0] = NULL;
+        node->child[1] = NULL;
+
+        // bounds of the triangles and of their centroids
+        GLfloat cmin[3];
+        GLfloat cmax[3];
+        emptyBounds(node->bmin, node->bmax);
+        emptyBounds(cmin, cmax);
+        for(int i = start; i < start + count; i++) {
+            growBounds(node->bmin, node->bmax, refs[i].bmin, refs[i].bmax);
+            growBounds(cmin, cmax, refs[i].centroid, refs[i].centroid);
+        }
+
+        if(count <= BVH_MAX_LEAF)
+            return node;
+
+        // find the cheapest split plane along any axis by binning centroids
+        GLfloat bestCost = FLT_MAX;
+        int bestAxis = -1;
+        int bestSplit = 0;
+
+        for(int axis = 0; axis < 3 && depth < BVH_MAX_SAH_DEPTH; axis++) {
+            GLfloat extent = cmax[axis] - cmin[axis];
+            if(extent <= 0.0f)
+                continue; // every centroid is in the same place along this axis
+
+            int binCount[BVH_BINS];
+            GLfloat binMin[BVH_BINS][3];
+            GLfloat binMax[BVH_BINS][3];
+            for(int b = 0; b < BVH_BINS; b++) {
+                binCount[b] = 0;
+                emptyBounds(binMin[b], binMax[b]);
+            }
+
+            GLfloat scale = (GLfloat)BVH_BINS / extent;
+            for(int i = start; i < start + count; i++) {
+                int b = std::min(BVH_BINS - 1, (int)((refs[i].centroid[axis] - cmin[axis]) * scale));
+                binCount[b]++;
+                growBounds(binMin[b], binMax[b], refs[i].bmin, refs[i].bmax);
+            }
+
+            // sweep from the right first so the left sweep can finish each cost
+            GLfloat rightArea[BVH_BINS];
+            int rightCount[BVH_BINS];
+            GLfloat accMin[3];
+            GLfloat accMax[3];
+            int acc = 0;
+            emptyBounds(accMin, accMax);
+            for(int b = BVH_BINS - 1; b > 0; b--) {
+                acc += binCount[b];
+                growBounds(accMin, accMax, binMin[b], binMax[b]);
+                rightCount[b] = acc;
+                rightArea[b] = (acc > 0) ? surfaceArea(accMin, accMax) : 0.0f;
+            }
+
+            acc = 0;
+            emptyBounds(accMin, accMax);
+            for(int b = 0; b < BVH_BINS - 1; b++) {
+                acc += binCount[b];
+                growBounds(accMin, accMax, binMin[b], binMax[b]);
+                if(acc == 0 || rightCount[b + 1] == 0)
+                    continue;
+
+                GLfloat cost = acc * surfaceArea(accMin, accMax) + rightCount[b + 1] * rightArea[b + 1];
+                if(cost < bestCost) {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestSplit = b + 1;
+                }
+            }
+        }
+
+        int mid;
+        if(bestAxis == -1) {
+            // centroids are all identical (or the tree is too deep), only split if the leaf would be too big
+            if(count <= BVH_FORCE_LEAF)
+                return node;
+            mid = start + count / 2;
+        } else {
+            // compare against the cost of just testing every triangle (traversal step costs about one triangle)
+            GLfloat parentArea = surfaceArea(node->bmin, node->bmax);
+            GLfloat splitCost = 1.0f + bestCost / std::max(parentArea, FLT_MIN);
+            if(splitCost >= (GLfloat)count && count <= BVH_FORCE_LEAF)
+                return node;
+
+            GLfloat scale = (GLfloat)BVH_BINS / (cmax[bestAxis] - cmin[bestAxis]);
+            GLfloat axisMin = cmin[bestAxis];
+            BuildRef* split = std::partition(refs + start, refs + start + count, [=](const BuildRef& r) {
+                return std::min(BVH_BINS - 1, (int)((r.centroid[bestAxis] - axisMin) * scale)) < bestSplit;
+            });
+            mid = (int)(split - refs);
+        }
+
+        // left half goes to a new thread while there are threads left to hand out
+        if(threadDepth > 0 && count >= BVH_PARALLEL_SIZE) {
+            std::thread worker([&]() {
+                node->child[0] = buildRecursive(refs, start, mid - start, depth + 1, threadDepth - 1);
+            });
+            node->child[1] = buildRecursive(refs, mid, start + count - mid, depth + 1, threadDepth - 1);
+            worker.join();
+        } else {
+            node->child[0] = buildRecursive(refs, start, mid - start, depth + 1, 0);
+            node->child[1] = buildRecursive(refs, mid, start + count - mid, depth + 1, 0);
+        }
+
+        return node;
+    }
+
+    /* write the temporary tree into the flat node array (depth first) and free it as we go */
+    void flattenTree(BuildNode* node, std::vector<BVHNode>* nodes) {
+        int index = (int)nodes->size();
+        nodes->push_back(BVHNode());
+
+        BVHNode* flat = &nodes->at(index);
+        for(int i = 0; i < 3; i++) {
+            flat->bmin[i] = node->bmin[i];
+            flat->bmax[i] = node->bmax[i];
+        }
+
+        if(node->child[0] == NULL) {
+            flat->offset = node->start;
+            flat->count = node->count;
+        } else {
+            flattenTree(node->child[0], nodes);
+            int right = (int)nodes->size();
+            flattenTree(node->child[1], nodes);
+
+            // push_back may have moved the array
+            nodes->at(index).offset = right;
+            nodes->at(index).count = 0;
+        }
+
+        delete node;
+    }
+
+    /* builds the tree over a list of triangles, srcIds gives the primitive each triangle came from */
+    BVH* buildFromTris(std::vector<BVHTri>* srcTris, std::vector<int>* srcIds, int numThreads) {
+        BVH* myBVH = new BVH;
+        int numTris = (int)srcTris->size();
+
+        if(numTris == 0) {
+            BVHNode empty;
+            emptyBounds(empty.bmin, empty.bmax);
+            empty.offset = 0;
+            empty.count = 0;
+            myBVH->nodes.push_back(empty);
+            return myBVH;
+        }
+
+        std::vector<BuildRef> refs(numTris);
+        parallelFor(0, numTris, numThreads, [&](size_t first, size_t last) {
+            for(size_t i = first; i < last; i++) {
+                BuildRef& r = refs[i];
+                const BVHTri& t = srcTris->at(i);
+                r.tri = (int)i;
+                for(int a = 0; a < 3; a++) {
+                    GLfloat v0 = (&t.pts[0].x_)[a];
+                    GLfloat v1 = (&t.pts[1].x_)[a];
+                    GLfloat v2 = (&t.pts[2].x_)[a];
+                    r.bmin[a] = std::min(v0, std::min(v1, v2));
+                    r.bmax[a] = std::max(v0, std::max(v1, v2));
+                    r.centroid[a] = 0.5f * (r.bmin[a] + r.bmax[a]);
+                }
+            }
+        });
+
+        // enough levels of threading to keep every core busy
+        int threads = getNumThreads(numThreads);
+        int threadDepth = 0;
+        while((1 << threadDepth) < threads)
+            threadDepth++;
+
+        BuildNode* root = buildRecursive(&refs[0], 0, numTris, 0, threadDepth);
+
+        myBVH->nodes.reserve(2 * numTris / BVH_MAX_LEAF + 1);
+        flattenTree(root, &myBVH->nodes);
+
+        // copy triangles into leaf order so each leaf reads one contiguous block
+        myBVH->tris.resize(numTris);
+        myBVH->primIds.resize(numTris);
+        parallelFor(0, numTris, numThreads, [&](size_t first, size_t last) {
+            for(size_t i = first; i < last; i++) {
+                myBVH->tris[i] = srcTris->at(refs[i].tri);
+                myBVH->primIds[i] = srcIds->at(refs[i].tri);
+            }
+        });
+
+        return myBVH;
+    }
+
+    /* build a BVH over every facet of an stl model, hit.prim is the facet index */
+    BVH* buildBVH(Model* myModel, int numThreads = 0) {
+        std::vector<BVHTri> tris(myModel->size());
+        std::vector<int> ids(myModel->size());
+
+        for(unsigned int i = 0; i < myModel->size(); i++) {
+            for(int j = 0; j < 3; j++)
+                tris[i].pts[j] = myModel->at(i)->pts[j];
+            ids[i] = (int)i;
+        }
+
+        return buildFromTris(&tris, &ids, numThreads);
+    }
+
+    /* build a BVH over an objectParser model, each quad is split into two triangles and hit.prim is the quad index */
+    BVH* buildBVH(objParse::Model* myModel, int numThreads = 0) {
+        std::vector<BVHTri> tris(myModel->size() * 2);
+        std::vector<int> ids(myModel->size() * 2);
+
+        for(unsigned int i = 0; i < myModel->size(); i++) {
+            objParse::Quadfloat3* myquad = myModel->at(i);
+
+            tris[2 * i].pts[0] = myquad->pts[0];
+            tris[2 * i].pts[1] = myquad->pts[1];
+            tris[2 * i].pts[2] = myquad->pts[2];
+
+            tris[2 * i + 1].pts[0] = myquad->pts[0];
+            tris[2 * i + 1].pts[1] = myquad->pts[2];
+            tris[2 * i + 1].pts[2] = myquad->pts[3];
+
+            ids[2 * i] = (int)i;
+            ids[2 * i + 1] = (int)i;
+        }
+
+        return buildFromTris(&tris, &ids, numThreads);
+    }
+
+//-------------------------------------------------------------
+// small vector helpers for the queries
+
+    objParse::GLfloat3 sub3(const objParse::GLfloat3& a, const objParse::GLfloat3& b) {
+        objParse::GLfloat3 r;
+        r.x_ = a.x_ - b.x_;
+        r.y_ = a.y_ - b.y_;
+        r.z_ = a.z_ - b.z_;
+        return r;
+    }
+
+    objParse::GLfloat3 cross3(const objParse::GLfloat3& a, const objParse::GLfloat3& b) {
+        objParse::GLfloat3 r;
+        r.x_ = a.y_ * b.z_ - a.z_ * b.y_;
+        r.y_ = a.z_ * b.x_ - a.x_ * b.z_;
+        r.z_ = a.x_ * b.y_ - a.y_ * b.x_;
+        return r;
+    }
+
+    GLfloat dot3(const objParse::GLfloat3& a, const objParse::GLfloat3& b) {
+        return a.x_ * b.x_ + a.y_ * b.y_ + a.z_ * b.z_;
+    }
+
+    objParse::GLfloat3 madd3(const objParse::GLfloat3& a, const objParse::GLfloat3& b, GLfloat s) {
+        objParse::GLfloat3 r;
+        r.x_ = a.x_ + b.x_ * s;
+        r.y_ = a.y_ + b.y_ * s;
+        r.z_ = a.z_ + b.z_ * s;
+        return r;
+    }
+
+//-------------------------------------------------------------
+// ray queries
+
+    /* slab test, returns distance to the box or FLT_MAX if the ray misses it */
+    GLfloat rayBoxDistance(const BVHNode& node, const GLfloat origin[3], const GLfloat invDir[3], GLfloat tMax) {
+        GLfloat tNear = 0.0f;
+        GLfloat tFar = tMax;
+        for(int a = 0; a < 3; a++) {
+            GLfloat t0 = (node.bmin[a] - origin[a]) * invDir[a];
+            GLfloat t1 = (node.bmax[a] - origin[a]) * invDir[a];
+            tNear = std::max(tNear, std::min(t0, t1));
+            tFar = std::min(tFar, std::max(t0, t1));
+        }
+        return (tNear <= tFar) ? tNear : FLT_MAX;
+    }
+
+    /* Moller-Trumbore ray/triangle test, only updates hit when this triangle is closer */
+    bool rayTriangle(const Ray& ray, const BVHTri& tri, Hit* hit) {
+        objParse::GLfloat3 e1 = sub3(tri.pts[1], tri.pts[0]);
+        objParse::GLfloat3 e2 = sub3(tri.pts[2], tri.pts[0]);
+        objParse::GLfloat3 p = cross3(ray.dir, e2);
+
+        GLfloat det = dot3(e1, p);
+        if(fabsf(det) < 1e-12f)
+            return false; // ray is parallel to the triangle
+
+        GLfloat invDet = 1.0f / det;
+        objParse::GLfloat3 s = sub3(ray.origin, tri.pts[0]);
+        GLfloat u = dot3(s, p) * invDet;
+        if(u < 0.0f || u > 1.0f)
+            return false;
+
+        objParse::GLfloat3 q = cross3(s, e1);
+        GLfloat v = dot3(ray.dir, q) * invDet;
+        if(v < 0.0f || u + v > 1.0f)
+            return false;
+
+        GLfloat t = dot3(e2, q) * invDet;
+        if(t < 0.0f || t >= hit->t)
+            return false;
+
+        hit->t = t;
+        hit->u = u;
+        hit->v = v;
+        return true;
+    }
+
+    /* finds the first triangle along a ray, returns false (and hit->prim == -1) if nothing is hit */
+    bool intersectRay(BVH* myBVH, const Ray& ray, Hit* hit) {
+        hit->t = ray.tMax;
+        hit->u = 0.0f;
+        hit->v = 0.0f;
+        hit->prim = -1;
+
+        if(myBVH->tris.empty())
+            return false;
+
+        GLfloat origin[3] = { ray.origin.x_, ray.origin.y_, ray.origin.z_ };
+        GLfloat invDir[3] = { 1.0f / ray.dir.x_, 1.0f / ray.dir.y_, 1.0f / ray.dir.z_ };
+
+        if(rayBoxDistance(myBVH->nodes[0], origin, invDir, hit->t) == FLT_MAX)
+            return false;
+
+        int stack[BVH_STACK_SIZE];
+        int stackSize = 0;
+        stack[stackSize++] = 0;
+
+        while(stackSize > 0) {
+            const BVHNode& node = myBVH->nodes[stack[--stackSize]];
+
+            if(node.count > 0) {
+                for(int i = node.offset; i < node.offset + node.count; i++) {
+                    if(rayTriangle(ray, myBVH->tris[i], hit))
+                        hit->prim = myBVH->primIds[i];
+                }
+                continue;
+            }
+
+            // visit the closer child first so later boxes can be skipped once something is hit
+            int left = (int)(&node - &myBVH->nodes[0]) + 1;
+            int right = node.offset;
+            GLfloat dLeft = rayBoxDistance(myBVH->nodes[left], origin, invDir, hit->t);
+            GLfloat dRight = rayBoxDistance(myBVH->nodes[right], origin, invDir, hit->t);
+
+            if(dLeft > dRight) {
+                std::swap(dLeft, dRight);
+                std::swap(left, right);
+            }
+            if(dRight != FLT_MAX)
+                stack[stackSize++] = right;
+            if(dLeft != FLT_MAX)
+                stack[stackSize++] = left;
+        }
+
+        return hit->prim != -1;
+    }
+
+#ifdef __SSE__
+    /* traces 4 rays together, every node and triangle is tested against all 4 rays at once */
+    void intersectPacket(BVH* myBVH, const Ray* rays, Hit* hits, int numRays) {
+        // lanes past numRays are filled with copies of the first ray and then ignored
+        float ox[4], oy[4], oz[4], dx[4], dy[4], dz[4], tm[4];
+        for(int i = 0; i < 4; i++) {
+            const Ray& r = rays[(i < numRays) ? i : 0];
+            ox[i] = r.origin.x_; oy[i] = r.origin.y_; oz[i] = r.origin.z_;
+            dx[i] = r.dir.x_;    dy[i] = r.dir.y_;    dz[i] = r.dir.z_;
+            tm[i] = r.tMax;
+        }
+
+        __m128 orgX = _mm_loadu_ps(ox), orgY = _mm_loadu_ps(oy), orgZ = _mm_loadu_ps(oz);
+        __m128 dirX = _mm_loadu_ps(dx), dirY = _mm_loadu_ps(dy), dirZ = _mm_loadu_ps(dz);
+        __m128 one = _mm_set1_ps(1.0f);
+        __m128 zero = _mm_setzero_ps();
+        __m128 invX = _mm_div_ps(one, dirX), invY = _mm_div_ps(one, dirY), invZ = _mm_div_ps(one, dirZ);
+        __m128 tHit = _mm_loadu_ps(tm);
+        __m128 uHit = zero, vHit = zero;
+        __m128i primHit = _mm_set1_epi32(-1);
+
+        int stack[BVH_STACK_SIZE];
+        int stackSize = 0;
+
+        // returns the nearest entry distance over the rays that hit the box, FLT_MAX if none do
+        auto packetBox = [&](const BVHNode& node) -> float {
+            __m128 t0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.bmin[0]), orgX), invX);
+            __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.bmax[0]), orgX), invX);
+            __m128 tNear = _mm_max_ps(zero, _mm_min_ps(t0, t1));
+            __m128 tFar = _mm_min_ps(tHit, _mm_max_ps(t0, t1));
+
+            t0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.bmin[1]), orgY), invY);
+            t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.bmax[1]), orgY), invY);
+            tNear = _mm_max_ps(tNear, _mm_min_ps(t0, t1));
+            tFar = _mm_min_ps(tFar, _mm_max_ps(t0, t1));
+
+            t0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.bmin[2]), orgZ), invZ);
+            t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.bmax[2]), orgZ), invZ);
+            tNear = _mm_max_ps(tNear, _mm_min_ps(t0, t1));
+            tFar = _mm_min_ps(tFar, _mm_max_ps(t0, t1));
+
+            __m128 hitMask = _mm_cmple_ps(tNear, tFar);
+            if(_mm_movemask_ps(hitMask) == 0)
+                return FLT_MAX;
+
+            float nearest[4];
+            _mm_storeu_ps(nearest, _mm_or_ps(_mm_and_ps(hitMask, tNear), _mm_andnot_ps(hitMask, _mm_set1_ps(FLT_MAX))));
+            return std::min(std::min(nearest[0], nearest[1]), std::min(nearest[2], nearest[3]));
+        };
+
+        if(!myBVH->tris.empty() && packetBox(myBVH->nodes[0]) != FLT_MAX)
+            stack[stackSize++] = 0;
+
+        while(stackSize > 0) {
+            const BVHNode& node = myBVH->nodes[stack[--stackSize]];
+
+            if(node.count > 0) {
+                for(int i = node.offset; i < node.offset + node.count; i++) {
+                    const BVHTri& tri = myBVH->tris[i];
+
+                    __m128 v0x = _mm_set1_ps(tri.pts[0].x_), v0y = _mm_set1_ps(tri.pts[0].y_), v0z = _mm_set1_ps(tri.pts[0].z_);
+                    __m128 e1x = _mm_set1_ps(tri.pts[1].x_ - tri.pts[0].x_);
+                    __m128 e1y = _mm_set1_ps(tri.pts[1].y_ - tri.pts[0].y_);
+                    __m128 e1z = _mm_set1_ps(tri.pts[1].z_ - tri.pts[0].z_);
+                    __m128 e2x = _mm_set1_ps(tri.pts[2].x_ - tri.pts[0].x_);
+                    __m128 e2y = _mm_set1_ps(tri.pts[2].y_ - tri.pts[0].y_);
+                    __m128 e2z = _mm_set1_ps(tri.pts[2].z_ - tri.pts[0].z_);
+
+                    // p = dir x e2
+                    __m128 px = _mm_sub_ps(_mm_mul_ps(dirY, e2z), _mm_mul_ps(dirZ, e2y));
+                    __m128 py = _mm_sub_ps(_mm_mul_ps(dirZ, e2x), _mm_mul_ps(dirX, e2z));
+                    __m128 pz = _mm_sub_ps(_mm_mul_ps(dirX, e2y), _mm_mul_ps(dirY, e2x));
+
+                    __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+                    __m128 invDet = _mm_div_ps(one, det);
+
+                    __m128 sx = _mm_sub_ps(orgX, v0x), sy = _mm_sub_ps(orgY, v0y), sz = _mm_sub_ps(orgZ, v0z);
+                    __m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, px), _mm_mul_ps(sy, py)), _mm_mul_ps(sz, pz)), invDet);
+
+                    // q = s x e1
+                    __m128 qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y));
+                    __m128 qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z));
+                    __m128 qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+
+                    __m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dirX, qx), _mm_mul_ps(dirY, qy)), _mm_mul_ps(dirZ, qz)), invDet);
+                    __m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), invDet);
+
+                    // same rejection tests as rayTriangle, all done as masks
+                    __m128 absDet = _mm_andnot_ps(_mm_set1_ps(-0.0f), det);
+                    __m128 mask = _mm_cmpge_ps(absDet, _mm_set1_ps(1e-12f));
+                    mask = _mm_and_ps(mask, _mm_cmpge_ps(u, zero));
+                    mask = _mm_and_ps(mask, _mm_cmpge_ps(v, zero));
+                    mask = _mm_and_ps(mask, _mm_cmple_ps(_mm_add_ps(u, v), one));
+                    mask = _mm_and_ps(mask, _mm_cmpge_ps(t, zero));
+                    mask = _mm_and_ps(mask, _mm_cmplt_ps(t, tHit));
+
+                    if(_mm_movemask_ps(mask) == 0)
+                        continue;
+
+                    tHit = _mm_or_ps(_mm_and_ps(mask, t), _mm_andnot_ps(mask, tHit));
+                    uHit = _mm_or_ps(_mm_and_ps(mask, u), _mm_andnot_ps(mask, uHit));
+                    vHit = _mm_or_ps(_mm_and_ps(mask, v), _mm_andnot_ps(mask, vHit));
+
+                    __m128i imask = _mm_castps_si128(mask);
+                    primHit = _mm_or_si128(_mm_and_si128(imask, _mm_set1_epi32(myBVH->primIds[i])), _mm_andnot_si128(imask, primHit));
+                }
+                continue;
+            }
+
+            int left = (int)(&node - &myBVH->nodes[0]) + 1;
+            int right = node.offset;
+            GLfloat dLeft = packetBox(myBVH->nodes[left]);
+            GLfloat dRight = packetBox(myBVH->nodes[right]);
+
+            if(dLeft > dRight) {
+                std::swap(dLeft, dRight);
+                std::swap(left, right);
+            }
+            if(dRight != FLT_MAX)
+                stack[stackSize++] = right;
+            if(dLeft != FLT_MAX)
+                stack[stackSize++] = left;
+        }
+
+        float tOut[4], uOut[4], vOut[4];
+        int primOut[4];
+        _mm_storeu_ps(tOut, tHit);
+        _mm_storeu_ps(uOut, uHit);
+        _mm_storeu_ps(vOut, vHit);
+        _mm_storeu_si128((__m128i*)primOut, primHit);
+
+        for(int i = 0; i < numRays && i < 4; i++) {
+            hits[i].t = tOut[i];
+            hits[i].u = uOut[i];
+            hits[i].v = vOut[i];
+            hits[i].prim = primOut[i];
+        }
+    }
+#endif // __SSE__
+
+    /* traces many rays at once, rays are handled 4 at a time with SSE when available
+        and the whole batch is split across threads. rays that travel in similar
+        directions from similar origins (like the pixels of a pick region) should be next to each other */
+    void intersectRays(BVH* myBVH, const Ray* rays, Hit* hits, int numRays, int numThreads = 0) {
+        int numPackets = (numRays + 3) / 4;
+
+        parallelFor(0, numPackets, numThreads, [&](size_t first, size_t last) {
+            for(size_t p = first; p < last; p++) {
+                int base = (int)p * 4;
+                int count = std::min(4, numRays - base);
+#ifdef __SSE__
+                intersectPacket(myBVH, rays + base, hits + base, count);
+#else
+                for(int i = 0; i < count; i++)
+                    intersectRay(myBVH, rays[base + i], &hits[base + i]);
+#endif // __SSE__
+            }
+        }, 64);
+    }
+
+//-------------------------------------------------------------
+// closest point queries
+
+    /* closest point on a triangle to p (Ericson, Real-Time Collision Detection 5.1.5) */
+    objParse::GLfloat3 closestPointTriangle(const objParse::GLfloat3& p, const BVHTri& tri) {
+        const objParse::GLfloat3& a = tri.pts[0];
+        const objParse::GLfloat3& b = tri.pts[1];
+        const objParse::GLfloat3& c = tri.pts[2];
+
+        objParse::GLfloat3 ab = sub3(b, a);
+        objParse::GLfloat3 ac = sub3(c, a);
+        objParse::GLfloat3 ap = sub3(p, a);
+
+        GLfloat d1 = dot3(ab, ap);
+        GLfloat d2 = dot3(ac, ap);
+        if(d1 <= 0.0f && d2 <= 0.0f)
+            return a;
+
+        objParse::GLfloat3 bp = sub3(p, b);
+        GLfloat d3 = dot3(ab, bp);
+        GLfloat d4 = dot3(ac, bp);
+        if(d3 >= 0.0f && d4 <= d3)
+            return b;
+
+        GLfloat vc = d1 * d4 - d3 * d2;
+        if(vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+            return madd3(a, ab, d1 / (d1 - d3));
+
+        objParse::GLfloat3 cp = sub3(p, c);
+        GLfloat d5 = dot3(ab, cp);
+        GLfloat d6 = dot3(ac, cp);
+        if(d6 >= 0.0f && d5 <= d6)
+            return c;
+
+        GLfloat vb = d5 * d2 - d1 * d6;
+        if(vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+            return madd3(a, ac, d2 / (d2 - d6));
+
+        GLfloat va = d3 * d6 - d5 * d4;
+        if(va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+            return madd3(b, sub3(c, b), (d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+        // inside the face
+        GLfloat denom = 1.0f / (va + vb + vc);
+        return madd3(madd3(a, ab, vb * denom), ac, vc * denom);
+    }
+
+    GLfloat pointBoxDistanceSq(const BVHNode& node, const objParse::GLfloat3& p) {
+        const GLfloat* pt = &p.x_;
+        GLfloat dist = 0.0f;
+        for(int a = 0; a < 3; a++) {
+            GLfloat d = std::max(std::max(node.bmin[a] - pt[a], 0.0f), pt[a] - node.bmax[a]);
+            dist += d * d;
+        }
+        return dist;
+    }
+
+    /* closest point on the surface to p, optionally limited to maxDist,
+        returns the primitive it lies on or -1 if the model is empty or nothing is close enough */
+    int closestPoint(BVH* myBVH, const objParse::GLfloat3& p, objParse::GLfloat3* result, GLfloat maxDist = FLT_MAX) {
+        int bestPrim = -1;
+        GLfloat bestDistSq = (maxDist == FLT_MAX) ? FLT_MAX : maxDist * maxDist;
+
+        if(myBVH->tris.empty())
+            return -1;
+
+        int stack[BVH_STACK_SIZE];
+        int stackSize = 0;
+        stack[stackSize++] = 0;
+
+        while(stackSize > 0) {
+            const BVHNode& node = myBVH->nodes[stack[--stackSize]];
+            if(pointBoxDistanceSq(node, p) >= bestDistSq)
+                continue; // something closer was found after this node was pushed
+
+            if(node.count > 0) {
+                for(int i = node.offset; i < node.offset + node.count; i++) {
+                    objParse::GLfloat3 q = closestPointTriangle(p, myBVH->tris[i]);
+                    objParse::GLfloat3 d = sub3(q, p);
+                    GLfloat distSq = dot3(d, d);
+                    if(distSq < bestDistSq) {
+                        bestDistSq = distSq;
+                        bestPrim = myBVH->primIds[i];
+                        *result = q;
+                    }
+                }
+                continue;
+            }
+
+            int left = (int)(&node - &myBVH->nodes[0]) + 1;
+            int right = node.offset;
+            GLfloat dLeft = pointBoxDistanceSq(myBVH->nodes[left], p);
+            GLfloat dRight = pointBoxDistanceSq(myBVH->nodes[right], p);
+
+            if(dLeft > dRight) {
+                std::swap(dLeft, dRight);
+                std::swap(left, right);
+            }
+            if(dRight < bestDistSq)
+                stack[stackSize++] = right;
+            if(dLeft < bestDistSq)
+                stack[stackSize++] = left;
+        }
+
+        return bestPrim;
+    }
+
+//-------------------------------------------------------------
+// box overlap queries
+
+    /* separating axis test between a triangle and an axis aligned box (Akenine-Moller) */
+    bool triangleOverlapsBox(const BVHTri& tri, const GLfloat center[3], const GLfloat half[3]) {
+        GLfloat v[3][3];
+        for(int i = 0; i < 3; i++) {
+            v[i][0] = tri.pts[i].x_ - center[0];
+            v[i][1] = tri.pts[i].y_ - center[1];
+            v[i][2] = tri.pts[i].z_ - center[2];
+        }
+
+        // box face normals, same as comparing bounding boxes
+        for(int a = 0; a < 3; a++) {
+            GLfloat lo = std::min(v[0][a], std::min(v[1][a], v[2][a]));
+            GLfloat hi = std::max(v[0][a], std::max(v[1][a], v[2][a]));
+            if(lo > half[a] || hi < -half[a])
+                return false;
+        }
+
+        GLfloat e[3][3];
+        for(int i = 0; i < 3; i++) {
+            for(int a = 0; a < 3; a++)
+                e[i][a] = v[(i + 1) % 3][a] - v[i][a];
+        }
+
+        // the 9 cross products of triangle edges and box axes
+        for(int i = 0; i < 3; i++) {
+            for(int a = 0; a < 3; a++) {
+                GLfloat axis[3] = { 0.0f, 0.0f, 0.0f };
+                int b = (a + 1) % 3;
+                int c = (a + 2) % 3;
+                axis[b] = -e[i][c];
+                axis[c] = e[i][b];
+
+                GLfloat p0 = v[0][0] * axis[0] + v[0][1] * axis[1] + v[0][2] * axis[2];
+                GLfloat p1 = v[1][0] * axis[0] + v[1][1] * axis[1] + v[1][2] * axis[2];
+                GLfloat p2 = v[2][0] * axis[0] + v[2][1] * axis[1] + v[2][2] * axis[2];
+                GLfloat r = half[0] * fabsf(axis[0]) + half[1] * fabsf(axis[1]) + half[2] * fabsf(axis[2]);
+
+                if(std::min(p0, std::min(p1, p2)) > r || std::max(p0, std::max(p1, p2)) < -r)
+                    return false;
+            }
+        }
+
+        // triangle plane
+        GLfloat n[3] = {
+            e[0][1] * e[1][2] - e[0][2] * e[1][1],
+            e[0][2] * e[1][0] - e[0][0] * e[1][2],
+            e[0][0] * e[1][1] - e[0][1] * e[1][0]
+        };
+        GLfloat d = n[0] * v[0][0] + n[1] * v[0][1] + n[2] * v[0][2];
+        GLfloat r = half[0] * fabsf(n[0]) + half[1] * fabsf(n[1]) + half[2] * fabsf(n[2]);
+
+        return fabsf(d) <= r;
+    }
+
+    /* collects every primitive touching the box [bmin, bmax], returns how many were found.
+        objParse quads show up once per triangle so a quad may be listed twice */
+    int overlapBox(BVH* myBVH, const objParse::GLfloat3& bmin, const objParse::GLfloat3& bmax, std::vector<int>* prims) {
+        prims->clear();
+
+        if(myBVH->tris.empty())
+            return 0;
+
+        GLfloat qmin[3] = { bmin.x_, bmin.y_, bmin.z_ };
+        GLfloat qmax[3] = { bmax.x_, bmax.y_, bmax.z_ };
+        GLfloat center[3];
+        GLfloat half[3];
+        for(int a = 0; a < 3; a++) {
+            center[a] = 0.5f * (qmin[a] + qmax[a]);
+            half[a] = 0.5f * (qmax[a] - qmin[a]);
+        }
+
+        int stack[BVH_STACK_SIZE];
+        int stackSize = 0;
+        stack[stackSize++] = 0;
+
+        while(stackSize > 0) {
+            int index = stack[--stackSize];
+            const BVHNode& node = myBVH->nodes[index];
+
+            bool outside = false;
+            for(int a = 0; a < 3; a++) {
+                if(node.bmin[a] > qmax[a] || node.bmax[a] < qmin[a])
+                    outside = true;
+            }
+            if(outside)
+                continue;
+
+            if(node.count > 0) {
+                for(int i = node.offset; i < node.offset + node.count; i++) {
+                    if(triangleOverlapsBox(myBVH->tris[i], center, half))
+                        prims->push_back(myBVH->primIds[i]);
+                }
+                continue;
+            }
+
+            stack[stackSize++] = node.offset;
+            stack[stackSize++] = index + 1;
+        }
+
+        return (int)prims->size();
+    }
+
+} // end of namespace bvh
+} // end of namespace stl
+
+#endif // __JJC_STL_BVH_HPP__
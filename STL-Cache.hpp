@@ -0,0 +1,310 @@
+/*
+    STL-Cache, memory budgeted model cache for scenes with many .stl files
+    Copyright (C) 2026  STL-Parser contributors
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Author(s):
+        STL-Parser contributors
+
+    File Type: header/implementation, STL-Cache
+
+    Date Created: 10/18/2026
+
+    Date Last Modified: 10/18/2026
+
+    Purpose:
+        Owns parsed Models and their display lists, keyed by path and file version (modification time to the nanosecond plus size)
+        Keeps the total (CPU + estimated GPU) size under a byte budget by evicting the least recently used entries
+        Evicted entries remember what they were, ascii files are spilled to a binary copy so reloading
+        them is a single read instead of a full text parse
+        Spill files go in a private directory (mkdtemp, mode 0700) made for each cache, so other users and
+        other caches can never see, replace or delete them
+
+    Misc. Notes:
+        Model pointers and lists handed out by the cache stay valid until the next call that can evict
+        (getCachedModel, getCachedBot, setCacheBudget)
+
+*/
+
+#ifndef __JJC_STL_CACHE_HPP__
+#define __JJC_STL_CACHE_HPP__
+
+#include <STL-Parser.hpp>
+#include <STL-Writer.hpp>
+
+#include <sys/stat.h>
+#include <stdio.h>
+#include <stdlib.h> // for mkdtemp()
+#include <unistd.h> // for rmdir()
+
+#include <string>
+#include <list>
+#include <unordered_map>
+
+namespace stl {
+
+    // one version of a file on disk, whole second mtimes alone miss a part re-exported in the same second
+    struct FileStamp {
+        time_t seconds;
+        long nanoseconds;
+        off_t size;
+    };
+
+    struct CacheEntry {
+        std::string path;
+        FileStamp stamp;     // version of path when it was loaded
+        Model* model;        // NULL while evicted
+        GLuint list;         // 0 until getCachedBot is used, deleted on eviction
+        size_t cpuBytes;
+        size_t gpuBytes;     // rough size of the compiled display list
+        bool binary;         // format of path, so reloads skip sniffing the file
+        std::string spill;   // binary copy of an evicted ascii file, empty if there isnt one
+        FileStamp spillStamp; // version of path the spill was written from, the spill is only used while it matches stamp
+        std::list<CacheEntry*>::iterator lru;
+    };
+
+    struct ModelCache {
+        size_t budget;       // bytes
+        size_t used;         // bytes held by every resident entry
+        std::string spillParent; // where the spill directory is made, empty to never spill
+        std::string spillDir;    // private directory for this cache, made the first time something is spilled
+        unsigned int numSpills;  // names the spill files inside spillDir
+        std::unordered_map<std::string, CacheEntry*> entries; // resident and evicted
+        std::list<CacheEntry*> lru; // resident entries only, most recently used at the front
+    };
+
+    ModelCache* newModelCache(size_t budgetBytes, const char* spillDir = "/tmp") {
+        ModelCache* cache = new ModelCache;
+        cache->budget = budgetBytes;
+        cache->used = 0;
+        cache->spillParent = (spillDir != NULL) ? spillDir : "";
+        cache->numSpills = 0;
+        return cache;
+    }
+
+    /* makes the private spill directory if there isnt one yet, returns false if spilling is off or failed */
+    bool makeSpillDir(ModelCache* cache) {
+        if(!cache->spillDir.empty())
+            return true;
+        if(cache->spillParent.empty())
+            return false;
+
+        std::string dir = cache->spillParent + "/stlcache_XXXXXX";
+        std::vector<char> name(dir.begin(), dir.end());
+        name.push_back('\0');
+
+        if(mkdtemp(&name[0]) == NULL) {
+            std::cerr << "Cannot make spill directory in " << cache->spillParent << ", spilling is off" << std::endl;
+            cache->spillParent.clear(); // dont try again on every eviction
+            return false;
+        }
+
+        cache->spillDir = &name[0];
+        return true;
+    }
+
+    void removeSpill(CacheEntry* entry) {
+        if(!entry->spill.empty())
+            remove(entry->spill.c_str());
+        entry->spill.clear();
+    }
+
+    /* CPU memory held by a parsed Model: the pointer array plus one heap block per facet */
+    size_t getModelFootprint(Model* myModel) {
+        const size_t heapOverhead = 16; // malloc bookkeeping for each facet allocation
+        return sizeof(Model) + myModel->capacity() * sizeof(triFloat3*) + myModel->size() * (sizeof(triFloat3) + heapOverhead);
+    }
+
+    /* all zero if path cant be stat'ed */
+    FileStamp getFileStamp(const char* path) {
+        FileStamp stamp;
+        stamp.seconds = 0;
+        stamp.nanoseconds = 0;
+        stamp.size = 0;
+
+        struct stat info;
+        if(stat(path, &info) == 0) {
+            stamp.seconds = info.st_mtim.tv_sec;
+            stamp.nanoseconds = info.st_mtim.tv_nsec;
+            stamp.size = info.st_size;
+        }
+        return stamp;
+    }
+
+    inline bool sameFileStamp(const FileStamp& a, const FileStamp& b) {
+        return a.seconds == b.seconds && a.nanoseconds == b.nanoseconds && a.size == b.size;
+    }
+
+    /* frees the Model and display list of a resident entry, the entry itself stays so it can be reloaded */
+    void evictEntry(ModelCache* cache, CacheEntry* entry, bool allowSpill = true) {
+        if(entry->model == NULL)
+            return;
+
+        // ascii files are slow to parse, keep a binary copy around for next time
+        if(allowSpill && !entry->binary && entry->spill.empty() && makeSpillDir(cache)) {
+            char name[32];
+            snprintf(name, sizeof(name), "/%u.stl", cache->numSpills++);
+            std::string spill = cache->spillDir + name;
+            if(writeFileBinary(entry->model, spill.c_str())) {
+                entry->spill = spill;
+                entry->spillStamp = entry->stamp;
+            } else {
+                remove(spill.c_str());
+            }
+        }
+
+        if(entry->list != 0)
+            glDeleteLists(entry->list, 1);
+        freeModel(entry->model);
+
+        cache->used -= entry->cpuBytes + entry->gpuBytes;
+        cache->lru.erase(entry->lru);
+
+        entry->model = NULL;
+        entry->list = 0;
+        entry->cpuBytes = 0;
+        entry->gpuBytes = 0;
+    }
+
+    /* evicts from the back of the LRU list until the cache fits its budget, keep is never evicted */
+    void trimCache(ModelCache* cache, CacheEntry* keep = NULL) {
+        while(cache->used > cache->budget && !cache->lru.empty()) {
+            CacheEntry* victim = cache->lru.back();
+            if(victim == keep) {
+                if(cache->lru.size() == 1)
+                    break; // the entry in use is bigger than the whole budget
+                cache->lru.splice(cache->lru.begin(), cache->lru, keep->lru);
+                continue;
+            }
+            evictEntry(cache, victim);
+        }
+    }
+
+    void setCacheBudget(ModelCache* cache, size_t budgetBytes) {
+        cache->budget = budgetBytes;
+        trimCache(cache);
+    }
+
+    /* parses entry->path (or its spill file), nothing else is touched */
+    void loadEntry(CacheEntry* entry) {
+        std::vector<char> buffer;
+
+        if(!entry->spill.empty() && sameFileStamp(entry->spillStamp, entry->stamp) && readFileBuffer((char*)entry->spill.c_str(), &buffer)) {
+            entry->model = parseBufferBinary(buffer.empty() ? NULL : &buffer[0], buffer.size());
+            return;
+        }
+        removeSpill(entry); // missing or made from an older version of the file
+
+        if(!readFileBuffer((char*)entry->path.c_str(), &buffer)) {
+            std::cerr << "Invalid filename" << std::endl;
+            exit(1);
+        }
+
+        entry->binary = isBinarySTL(buffer.empty() ? NULL : &buffer[0], buffer.size());
+        if(entry->binary) {
+            entry->model = parseBufferBinary(&buffer[0], buffer.size());
+        } else {
+            openFile((char*)entry->path.c_str());
+            entry->model = parseFileAscii();
+        }
+    }
+
+    /* returns the Model for path, loading it if it isnt resident or the file has changed */
+    CacheEntry* useEntry(ModelCache* cache, char* path) {
+        FileStamp stamp = getFileStamp(path);
+
+        CacheEntry* entry;
+        std::unordered_map<std::string, CacheEntry*>::iterator found = cache->entries.find(path);
+
+        if(found == cache->entries.end()) {
+            entry = new CacheEntry;
+            entry->path = path;
+            entry->stamp = stamp;
+            entry->model = NULL;
+            entry->list = 0;
+            entry->cpuBytes = 0;
+            entry->gpuBytes = 0;
+            entry->binary = false;
+            entry->spillStamp = stamp;
+            cache->entries[path] = entry;
+        } else {
+            entry = found->second;
+
+            // file was changed on disk, throw away everything we knew about it
+            if(!sameFileStamp(entry->stamp, stamp)) {
+                evictEntry(cache, entry, false);
+                removeSpill(entry);
+                entry->stamp = stamp;
+            }
+        }
+
+        if(entry->model == NULL) {
+            loadEntry(entry);
+            entry->cpuBytes = getModelFootprint(entry->model);
+            cache->used += entry->cpuBytes;
+            cache->lru.push_front(entry);
+            entry->lru = cache->lru.begin();
+        } else {
+            cache->lru.splice(cache->lru.begin(), cache->lru, entry->lru);
+        }
+
+        return entry;
+    }
+
+    Model* getCachedModel(ModelCache* cache, char* path) {
+        CacheEntry* entry = useEntry(cache, path);
+        trimCache(cache, entry);
+        return entry->model;
+    }
+
+    /* display list for path (same as getBot), compiled once and kept until the entry is evicted */
+    GLuint getCachedBot(ModelCache* cache, char* path) {
+        CacheEntry* entry = useEntry(cache, path);
+
+        if(entry->list == 0) {
+            entry->list = getBot(entry->model);
+            entry->gpuBytes = entry->model->size() * 3 * 6 * sizeof(GLfloat); // position and color per corner
+            cache->used += entry->gpuBytes;
+        }
+
+        trimCache(cache, entry);
+        return entry->list;
+    }
+
+    /* frees every resident Model and display list and deletes the spill files and their directory */
+    void clearModelCache(ModelCache* cache) {
+        std::unordered_map<std::string, CacheEntry*>::iterator it;
+        for(it = cache->entries.begin(); it != cache->entries.end(); ++it) {
+            CacheEntry* entry = it->second;
+            if(entry->model != NULL) {
+                if(entry->list != 0)
+                    glDeleteLists(entry->list, 1);
+                freeModel(entry->model);
+            }
+            removeSpill(entry);
+            delete entry;
+        }
+
+        if(!cache->spillDir.empty()) {
+            rmdir(cache->spillDir.c_str());
+            cache->spillDir.clear();
+        }
+
+        cache->entries.clear();
+        cache->lru.clear();
+        cache->used = 0;
+    }
+
+}
+
+#endif // __JJC_STL_CACHE_HPP__
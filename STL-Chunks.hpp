@@ -0,0 +1,253 @@
+/*
+    STL-Chunks, spatially chunked display lists for STL-Parser models
+    Copyright (C) 2026  STL-Parser contributors
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Author(s):
+        STL-Parser contributors
+
+    File Type: header/implementation, STL-Chunks
+
+    Date Created: 10/18/2026
+
+    Date Last Modified: 10/18/2026
+
+    Purpose:
+        Alternative to stl::getBot for large models
+        Facets are sorted into a uniform grid sized so each cell holds roughly the same number of facets,
+        every non-empty cell gets its own display list and bounding box
+        drawChunked() culls cells against the current view frustum before calling their lists
+
+*/
+
+#ifndef __JJC_STL_CHUNKS_HPP__
+#define __JJC_STL_CHUNKS_HPP__
+
+#include <STL-Parser.hpp>
+
+#include <vector>
+#include <algorithm>
+#include <math.h>
+#include <float.h>
+
+namespace stl {
+
+    // one grid cell of a chunked model
+    struct ModelChunk {
+        GLfloat bmin[3]; // tight bounds of the facets in this cell
+        GLfloat bmax[3];
+        GLuint list;
+        unsigned int numFacets;
+    };
+
+    struct ChunkedModel {
+        std::vector<ModelChunk> chunks;
+        int dims[3]; // grid resolution along each axis
+    };
+
+    // 6 clip planes as ax + by + cz + d, normals point into the frustum
+    struct Frustum {
+        GLfloat planes[6][4];
+    };
+
+    /* splits a model into grid cells holding about facetsPerChunk facets each
+        and compiles one display list per cell (same look as getBot) */
+    ChunkedModel* getChunkedBot(Model* myModel, unsigned int facetsPerChunk = 4096) {
+        ChunkedModel* myChunks = new ChunkedModel;
+        myChunks->dims[0] = myChunks->dims[1] = myChunks->dims[2] = 1;
+
+        unsigned int numFacets = myModel->size();
+        if(numFacets == 0)
+            return myChunks;
+
+        if(facetsPerChunk == 0)
+            facetsPerChunk = 1;
+
+        // bounds of all facet centroids, facets are binned by centroid
+        GLfloat lo[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+        GLfloat hi[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+        std::vector<GLfloat> centroids(numFacets * 3);
+
+        for(unsigned int i = 0; i < numFacets; i++) {
+            triFloat3* tf3 = myModel->at(i);
+            GLfloat c[3];
+            c[0] = (tf3->pts[0].x_ + tf3->pts[1].x_ + tf3->pts[2].x_) / 3.0f;
+            c[1] = (tf3->pts[0].y_ + tf3->pts[1].y_ + tf3->pts[2].y_) / 3.0f;
+            c[2] = (tf3->pts[0].z_ + tf3->pts[1].z_ + tf3->pts[2].z_) / 3.0f;
+
+            for(int a = 0; a < 3; a++) {
+                centroids[i * 3 + a] = c[a];
+                lo[a] = std::min(lo[a], c[a]);
+                hi[a] = std::max(hi[a], c[a]);
+            }
+        }
+
+        // pick a cubic cell size that gives about numFacets / facetsPerChunk cells,
+        // flat models get a small thickness so the volume isnt zero
+        GLfloat extent[3];
+        GLfloat maxExtent = 0.0f;
+        for(int a = 0; a < 3; a++)
+            maxExtent = std::max(maxExtent, hi[a] - lo[a]);
+        for(int a = 0; a < 3; a++)
+            extent[a] = std::max(hi[a] - lo[a], maxExtent * 1e-3f + FLT_MIN);
+
+        double targetCells = ceil((double)numFacets / (double)facetsPerChunk);
+        double cellSize = cbrt((double)extent[0] * extent[1] * extent[2] / targetCells);
+
+        int numCells = 1;
+        for(int a = 0; a < 3; a++) {
+            myChunks->dims[a] = std::max(1, std::min(1024, (int)ceil(extent[a] / cellSize)));
+            numCells *= myChunks->dims[a];
+        }
+
+        // counting sort of facets into cells
+        std::vector<int> cellOf(numFacets);
+        std::vector<unsigned int> cellStart(numCells + 1, 0);
+        for(unsigned int i = 0; i < numFacets; i++) {
+            int cell = 0;
+            for(int a = 2; a >= 0; a--) {
+                int k = (int)((centroids[i * 3 + a] - lo[a]) / extent[a] * myChunks->dims[a]);
+                k = std::max(0, std::min(myChunks->dims[a] - 1, k));
+                cell = cell * myChunks->dims[a] + k;
+            }
+            cellOf[i] = cell;
+            cellStart[cell + 1]++;
+        }
+        for(int c = 0; c < numCells; c++)
+            cellStart[c + 1] += cellStart[c];
+
+        std::vector<unsigned int> sorted(numFacets);
+        std::vector<unsigned int> fill(cellStart.begin(), cellStart.end() - 1);
+        for(unsigned int i = 0; i < numFacets; i++)
+            sorted[fill[cellOf[i]]++] = i;
+
+        // one display list per non-empty cell
+        for(int c = 0; c < numCells; c++) {
+            if(cellStart[c] == cellStart[c + 1])
+                continue;
+
+            ModelChunk chunk;
+            chunk.numFacets = cellStart[c + 1] - cellStart[c];
+            for(int a = 0; a < 3; a++) {
+                chunk.bmin[a] = FLT_MAX;
+                chunk.bmax[a] = -FLT_MAX;
+            }
+
+            chunk.list = glGenLists(1);
+            glNewList(chunk.list, GL_COMPILE);
+            glBegin(GL_TRIANGLES);
+
+                for(unsigned int i = cellStart[c]; i < cellStart[c + 1]; i++) {
+                    triFloat3* tf3 = myModel->at(sorted[i]);
+
+                    // all triangles will be green
+                    glColor3f(0.0f, 1.0f, 0.0f);
+
+                    for(int j = 0; j < 3; j++) {
+                        glVertex3f(tf3->pts[j].x_, tf3->pts[j].y_, tf3->pts[j].z_);
+
+                        const GLfloat* p = &tf3->pts[j].x_;
+                        for(int a = 0; a < 3; a++) {
+                            chunk.bmin[a] = std::min(chunk.bmin[a], p[a]);
+                            chunk.bmax[a] = std::max(chunk.bmax[a], p[a]);
+                        }
+                    }
+                }
+
+            glEnd();
+            glEndList();
+
+            myChunks->chunks.push_back(chunk);
+        }
+
+        std::cout << "Chunk grid: " << myChunks->dims[0] << "x" << myChunks->dims[1] << "x" << myChunks->dims[2]
+                  << " with " << myChunks->chunks.size() << " non-empty cells" << std::endl;
+
+        return myChunks;
+    }
+
+    /* pull the view frustum out of the current projection and modelview matrices,
+        planes are in the same space as whatever gets drawn with those matrices */
+    void getFrustum(Frustum* frustum) {
+        GLfloat proj[16];
+        GLfloat modl[16];
+        GLfloat clip[16];
+
+        glGetFloatv(GL_PROJECTION_MATRIX, proj);
+        glGetFloatv(GL_MODELVIEW_MATRIX, modl);
+
+        // clip = proj * modl, OpenGL matrices are column major
+        for(int col = 0; col < 4; col++) {
+            for(int row = 0; row < 4; row++) {
+                clip[col * 4 + row] = 0.0f;
+                for(int k = 0; k < 4; k++)
+                    clip[col * 4 + row] += proj[k * 4 + row] * modl[col * 4 + k];
+            }
+        }
+
+        // each plane is row 3 plus or minus one of the other rows
+        for(int p = 0; p < 6; p++) {
+            int row = p / 2;
+            GLfloat sign = (p % 2 == 0) ? 1.0f : -1.0f;
+            GLfloat len = 0.0f;
+
+            for(int col = 0; col < 4; col++)
+                frustum->planes[p][col] = clip[col * 4 + 3] + sign * clip[col * 4 + row];
+
+            for(int k = 0; k < 3; k++)
+                len += frustum->planes[p][k] * frustum->planes[p][k];
+
+            len = sqrtf(len);
+            if(len > 0.0f) {
+                for(int k = 0; k < 4; k++)
+                    frustum->planes[p][k] /= len;
+            }
+        }
+    }
+
+    /* conservative test, only rejects boxes that are completely outside one plane */
+    bool boxInFrustum(Frustum* frustum, const GLfloat bmin[3], const GLfloat bmax[3]) {
+        for(int p = 0; p < 6; p++) {
+            const GLfloat* pl = frustum->planes[p];
+
+            // corner of the box furthest along the plane normal
+            GLfloat x = (pl[0] >= 0.0f) ? bmax[0] : bmin[0];
+            GLfloat y = (pl[1] >= 0.0f) ? bmax[1] : bmin[1];
+            GLfloat z = (pl[2] >= 0.0f) ? bmax[2] : bmin[2];
+
+            if(pl[0] * x + pl[1] * y + pl[2] * z + pl[3] < 0.0f)
+                return false;
+        }
+        return true;
+    }
+
+    /* draws every chunk that can be seen with the current matrices, returns how many were drawn */
+    int drawChunked(ChunkedModel* myChunks) {
+        Frustum frustum;
+        getFrustum(&frustum);
+
+        int drawn = 0;
+        for(unsigned int i = 0; i < myChunks->chunks.size(); i++) {
+            ModelChunk& chunk = myChunks->chunks[i];
+            if(boxInFrustum(&frustum, chunk.bmin, chunk.bmax)) {
+                glCallList(chunk.list);
+                drawn++;
+            }
+        }
+
+        return drawn;
+    }
+
+}
+
+#endif // __JJC_STL_CHUNKS_HPP__
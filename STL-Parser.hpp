@@ -20,7 +20,7 @@
 
     Date Created: 8/7/2016
 
-    Date Last Modified: 8/14/2016
+    Date Last Modified: 10/18/2026
 
     Purpose:
         Parse simple CAD .stl files
@@ -42,10 +42,26 @@
 
 #include <fstream>
 #include <iostream>
+#include <sstream>
 #include <objectParser.hpp>
 //#include <string.h> // for strcmp()
 #include <string>
 
+// welding vertices into an IndexedMesh
+#include <unordered_map>
+#include <string.h> // for memcpy()
+#include <stdlib.h> // for strtof()
+#include <math.h>   // for isfinite()
+#include <algorithm>
+
+// byte swapping binary records on big endian hosts
+#ifdef __SSSE3__
+#include <tmmintrin.h>
+#endif // __SSSE3__
+#ifdef __ARM_NEON
+#include <arm_neon.h>
+#endif // __ARM_NEON
+
 namespace stl { // objectParser.hpp has many similarly named functions and so we use a different namespace to differentiate
 
     // stores 3 vertices, full color information and a normal vector for each face
@@ -61,10 +77,22 @@ namespace stl { // objectParser.hpp has many similarly named functions and so we
 
     typedef std::vector<Model*> MultiModel;
 
+    // welded triangle mesh, every distinct vertex position is stored once
+    struct IndexedMesh {
+        std::vector<objParse::GLfloat3> verts;
+        std::vector<objParse::GLfloat3> normals; // one per triangle, copied from the facets
+        std::vector<unsigned int> indices;       // 3 per triangle
+    };
+
     std::ifstream ifile; // starts out uninitialized
     bool fileOpened = false;
     char* _filename;
 
+    // thread helpers live in objectParser.hpp so both libraries can use them
+    using objParse::getNumThreads;
+    using objParse::parallelFor;
+    using objParse::parallelSort;
+
 //-------------------------------------------------------------
 // structs/unions/functions used when parsing binary .stl files
 
@@ -101,28 +129,90 @@ namespace stl { // objectParser.hpp has many similarly named functions and so we
         int int_; // ints are stored in little endian order
     };
 
-    void swapBytes(char arr[4]) {
-        // swap bytes 0 and 3
-        arr[0] = arr[0] ^ arr[3];
-        arr[3] = arr[0] ^ arr[3];
-        arr[0] = arr[0] ^ arr[3];
+//-------------------------------------------------------------
+// byte order, numbers in binary .stl files are always little endian
+
+// picked at compile time so little endian hosts dont pay anything,
+// define STL_FORCE_BYTESWAP to run the big endian path on any machine (for testing it on x86)
+#if defined(STL_FORCE_BYTESWAP) || (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+    #define STL_SWAP_BYTES 1
+#else
+    #define STL_SWAP_BYTES 0
+#endif
+
+    inline unsigned int byteSwap32(unsigned int word) {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_bswap32(word);
+#else
+        return (word >> 24) | ((word >> 8) & 0xFF00) | ((word << 8) & 0xFF0000) | (word << 24);
+#endif
+    }
+
+    /* reverses the bytes of every 4 byte word, 16 bytes at a time where there is a byte shuffle instruction.
+        src and dst may be the same buffer */
+    inline void swapWords32(const char* src, char* dst, size_t numWords) {
+        size_t i = 0;
+
+#if defined(__SSSE3__) || defined(__ARM_NEON)
+        size_t vectorWords = numWords & ~(size_t)3; // whole 16 byte groups
+#endif
+
+#if defined(__SSSE3__)
+        const __m128i reverse = _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+        for(; i < vectorWords; i += 4) {
+            __m128i words = _mm_loadu_si128((const __m128i*)(src + i * 4));
+            _mm_storeu_si128((__m128i*)(dst + i * 4), _mm_shuffle_epi8(words, reverse));
+        }
+#elif defined(__ARM_NEON)
+        for(; i < vectorWords; i += 4)
+            vst1q_u8((uint8_t*)(dst + i * 4), vrev32q_u8(vld1q_u8((const uint8_t*)(src + i * 4))));
+#endif
+
+        for(; i < numWords; i++) {
+            unsigned int word;
+            memcpy(&word, src + i * 4, 4);
+            word = byteSwap32(word);
+            memcpy(dst + i * 4, &word, 4);
+        }
+    }
+
+    /* little endian words to native order, or back again (its the same operation),
+        just a copy on little endian hosts */
+    inline void convertLittleEndian32(const char* src, char* dst, size_t numWords) {
+#if STL_SWAP_BYTES
+        swapWords32(src, dst, numWords);
+#else
+        if(src != dst)
+            memcpy(dst, src, numWords * 4);
+#endif
+    }
 
-        // swap bytes 1 and 2
-        arr[1] = arr[1] ^ arr[2];
-        arr[2] = arr[1] ^ arr[2];
-        arr[1] = arr[1] ^ arr[2];
+    /* facet count and other little endian integers, works the same on every host */
+    inline unsigned int readLittleEndian32(const char* bytes) {
+        const unsigned char* b = (const unsigned char*)bytes;
+        return (unsigned int)b[0] | ((unsigned int)b[1] << 8) | ((unsigned int)b[2] << 16) | ((unsigned int)b[3] << 24);
+    }
+
+    inline void writeLittleEndian32(char* bytes, unsigned int value) {
+        for(int i = 0; i < 4; i++)
+            bytes[i] = (char)((value >> (8 * i)) & 0xFF);
+    }
+
+    /* turns numFacets 50 byte records into 12 native floats each (normal, then the 3 corners) */
+    void unpackFacetRecords(const char* records, size_t numFacets, GLfloat* values) {
+        char* dst = (char*)values;
+        for(size_t i = 0; i < numFacets; i++)
+            convertLittleEndian32(records + i * 50, dst + i * 48, 12); // attribute bytes are skipped
+    }
+
+    void swapBytes(char arr[4]) {
+        swapWords32(arr, arr, 1);
     }
 
     // swap all things that need to be swapped
     void swapTriFloat3Union(triFloat3Union* tf3u) {
-        for(int i = 0; i < 3; i++) {
-            swapBytes(tf3u->pts[i].x_.byte);
-            swapBytes(tf3u->pts[i].y_.byte);
-            swapBytes(tf3u->pts[i].z_.byte);
-        }
-        swapBytes(tf3u->normal.x_.byte);
-        swapBytes(tf3u->normal.y_.byte);
-        swapBytes(tf3u->normal.z_.byte);
+        swapWords32((char*)tf3u->pts, (char*)tf3u->pts, 9);
+        swapWords32((char*)&tf3u->normal, (char*)&tf3u->normal, 3);
     }
 
     triFloat3* packTriFloat3(triFloat3Union* tf3u) {
@@ -146,6 +236,59 @@ namespace stl { // objectParser.hpp has many similarly named functions and so we
         return tf3;
     }
 
+//-------------------------------------------------------------
+// geometry fingerprints, used to spot the same mesh loaded from different files
+
+    const unsigned long long GEOMETRY_HASH_SEED = 0x9E3779B97F4A7C15ULL;
+
+    inline unsigned long long hashMix(unsigned long long hash, unsigned long long word) {
+        word *= 0x87C37B91114253D5ULL;
+        word = (word << 31) | (word >> 33);
+        hash ^= word * 0x4CF5AD432745937FULL;
+        hash = (hash << 27) | (hash >> 37);
+        return hash * 5 + 0x52DCE729;
+    }
+
+    /* folds the 48 geometry bytes of one facet (normal then 3 corners as little endian floats,
+        the same layout as a binary .stl record without its attribute bytes) into hash */
+    inline unsigned long long hashFacetBytes(const char* record, unsigned long long hash) {
+        for(int i = 0; i < 48; i += 8) {
+            unsigned long long word;
+            memcpy(&word, record + i, 8);
+            hash = hashMix(hash, word);
+        }
+        return hash;
+    }
+
+    /* same as hashFacetBytes but for a facet that has already been parsed,
+        so an ascii file and a binary file of the same mesh hash the same */
+    unsigned long long hashFacet(triFloat3* tf3, unsigned long long hash) {
+        char record[48];
+        memcpy(record, &tf3->normal, 12);
+        memcpy(record + 12, tf3->pts, 36);
+        convertLittleEndian32(record, record, 12); // same bytes a binary file would have
+        return hashFacetBytes(record, hash);
+    }
+
+    /* mixes in the facet count and spreads the bits out, call once after every facet is hashed */
+    unsigned long long finishHash(unsigned long long hash, unsigned long long numFacets) {
+        hash ^= numFacets;
+        hash ^= hash >> 33;
+        hash *= 0xFF51AFD7ED558CCDULL;
+        hash ^= hash >> 33;
+        hash *= 0xC4CEB9FE1A85EC53ULL;
+        hash ^= hash >> 33;
+        return hash;
+    }
+
+    /* fingerprint of the facet records of a binary .stl file (everything after the 84 byte header) */
+    unsigned long long hashBinaryFacets(const char* facets, unsigned int numFacets) {
+        unsigned long long hash = GEOMETRY_HASH_SEED;
+        for(unsigned int i = 0; i < numFacets; i++)
+            hash = hashFacetBytes(facets + i * 50, hash);
+        return finishHash(hash, numFacets);
+    }
+
 //-------------------------------------------------------------
 
     void openFile(char* filename) {
@@ -154,23 +297,58 @@ namespace stl { // objectParser.hpp has many similarly named functions and so we
         _filename = filename;
     }
 
-    /* parses ascii .stl file containing description of object
-        and makes a Model with it */
-    Model* parseFileAscii(void) {
+    /* reads the next token and checks it is the keyword the format says comes next */
+    bool expectToken(std::istream& ifile, std::string* str, const char* expected) {
+        if(!(ifile >> *str))
+            return false; // out of data, str still holds the previous token
+        return *str == expected;
+    }
 
-        //#define ifile STL::ifile // easier for Joe (no longer needed, should really just delete it, but im sentimental like that :) )
+    /* same as expectToken but leaves the stream where it was on a mismatch, used for the closing keywords
+        so a facet missing its end doesnt swallow the 'facet' of the next one.
+        at the end of the data there is nothing to rewind to (tellg would fail), so it just returns false */
+    bool expectTokenOrRewind(std::istream& ifile, std::string* str, const char* expected) {
+        if(!ifile.good())
+            return false;
+
+        std::streampos mark = ifile.tellg();
+        if(mark == std::streampos(-1) || !(ifile >> *str))
+            return false;
+        if(*str == expected)
+            return true;
+
+        ifile.clear(); // the token may have ended at the end of the data, seekg needs eofbit gone
+        ifile.seekg(mark);
+        return false;
+    }
 
-        ifile.open(_filename, ios_base::in);
+    /* reads the next token as a float, returns false if it isnt a whole finite number */
+    bool readFloatToken(std::istream& ifile, std::string* str, GLfloat* value) {
+        if(!(ifile >> *str)) {
+            *value = 0.0f; // truncated file, dont leave the facet with garbage in it
+            return false;
+        }
+        char* end;
+        *value = strtof(str->c_str(), &end);
+        return !str->empty() && *end == '\0' && isfinite(*value);
+    }
+
+    /* parses ascii .stl data from any stream and makes a Model with it, optionally fingerprints the geometry as it goes
+        (the stream parameter hides the global ifile so this can run on more than one thread) */
+    Model* parseStreamAscii(std::istream& ifile, unsigned long long* hash = NULL) {
+
+        //#define ifile STL::ifile // easier for Joe (no longer needed, should really just delete it, but im sentimental like that :) )
 
         Model* myModel = new Model;
         myModel->clear(); // STL::Model is just a vector
 
         int numFaces = 0;
+        int numMalformed = 0; // facets that didnt follow the format, they are still kept
+        unsigned long long myHash = GEOMETRY_HASH_SEED;
 
-        while(!ifile.eof()) { // while there is still unread data
+        std::string* str = new std::string;
 
-            std::string* str = new std::string;
-            ifile >> *str;
+        while(ifile >> *str) { // while there is still unread data
 
             // count the number of faces on model and parse each facet
             if(*str == "facet") {
@@ -178,46 +356,59 @@ namespace stl { // objectParser.hpp has many similarly named functions and so we
 
                 // allocate space for each facet
                 triFloat3* myFacet = new triFloat3;
+                bool valid = true;
 
                 // normal vector comes first
-                ifile >> *str; // should be 'normal' each time
+                valid &= expectToken(ifile, str, "normal");
 
                 // read next 3 items and convert to floats
-                ifile >> *str;
-                myFacet->normal.x_ = (GLfloat)atof(str->c_str());
-                ifile >> *str;
-                myFacet->normal.y_ = (GLfloat)atof(str->c_str());
-                ifile >> *str;
-                myFacet->normal.z_ = (GLfloat)atof(str->c_str());
+                valid &= readFloatToken(ifile, str, &myFacet->normal.x_);
+                valid &= readFloatToken(ifile, str, &myFacet->normal.y_);
+                valid &= readFloatToken(ifile, str, &myFacet->normal.z_);
 
-                // skip next 2 items 'outer' and 'loop'
-                ifile >> *str;
-                ifile >> *str;
+                // next 2 items are 'outer' and 'loop'
+                valid &= expectToken(ifile, str, "outer");
+                valid &= expectToken(ifile, str, "loop");
 
                 // read 3 vectors from file
                 for(int i = 0; i < 3; i++) {
-                    ifile >> *str; // 'vertex' not needed
-
-                    ifile >> *str;
-                    myFacet->pts[i].x_ = (GLfloat)atof(str->c_str());
-                    ifile >> *str;
-                    myFacet->pts[i].y_ = (GLfloat)atof(str->c_str());
-                    ifile >> *str;
-                    myFacet->pts[i].z_ = (GLfloat)atof(str->c_str());
+                    valid &= expectToken(ifile, str, "vertex");
+
+                    valid &= readFloatToken(ifile, str, &myFacet->pts[i].x_);
+                    valid &= readFloatToken(ifile, str, &myFacet->pts[i].y_);
+                    valid &= readFloatToken(ifile, str, &myFacet->pts[i].z_);
+                }
+
+                valid &= expectTokenOrRewind(ifile, str, "endloop");
+                valid &= expectTokenOrRewind(ifile, str, "endfacet");
+
+                if(!valid) {
+                    numMalformed++;
+                    if(numMalformed <= 10)
+                        std::cerr << "Warning: facet " << numFaces << " is malformed" << std::endl;
                 }
 
                 myModel->push_back(myFacet);
 
+                if(hash != NULL)
+                    myHash = hashFacet(myFacet, myHash);
+
             }
 
 
 
         }
 
+        delete str;
+
         std::cout << "Number of faces: " << numFaces << std::endl;
         std::cout << "Size of Model: " << myModel->size() << std::endl;
 
-        ifile.close();
+        if(numMalformed > 0)
+            std::cerr << "Warning: " << numMalformed << " malformed facets" << std::endl;
+
+        if(hash != NULL)
+            *hash = finishHash(myHash, myModel->size());
 
         return myModel;
 
@@ -227,73 +418,137 @@ namespace stl { // objectParser.hpp has many similarly named functions and so we
 
     }
 
-    /* same as function above but uses binary .stl files */
-    Model* parseFileBinary(void) {
+    /* parses ascii .stl file containing description of object
+        and makes a Model with it, optionally fingerprints the geometry as it goes */
+    Model* parseFileAscii(unsigned long long* hash = NULL) {
 
-        std::ifstream ifile;
+        ifile.open(_filename, ios_base::in);
 
-        ifile.open(_filename, ios::in | ios::binary);
-        if(!ifile.is_open()) {
-            std::cerr << "Invalid filename" << std::endl;
-            exit(1);
-        }
+        Model* myModel = parseStreamAscii(ifile, hash);
 
-        Model* myModel = new Model;
-        myModel->clear(); // STL::Model is just a vector
-        int numFaces = 0;
+        ifile.close();
 
-        // start at beginning of file
+        return myModel;
+
+    }
+
+    /* reads a whole file into buffer with a single read, returns false if it cant be opened */
+    bool readFileBuffer(char* filename, std::vector<char>* buffer) {
+        std::ifstream ifile(filename, ios::in | ios::binary);
+        if(!ifile.is_open())
+            return false;
+
+        ifile.seekg(0, ios_base::end);
+        std::streamoff length = ifile.tellg();
         ifile.seekg(0, ios_base::beg);
 
-        ifile.read(header, 80); // header is 80 bytes of stuff we dont really care about
+        buffer->resize((size_t)length);
+        if(length > 0)
+            ifile.read(&buffer->at(0), length);
 
-        int_o intUnion;
-        ifile.read(intUnion.byte, 4); // read 4 bytes in
+        ifile.close();
+        return true;
+    }
 
-        std::cout << "Pre-sort: " << intUnion.int_ << std::endl;
-        //swapBytes(intUnion.byte);
-        //std::cout << "Post-sort: " << intUnion.int_ << std::endl;
-        //return 0;
+    /* binary .stl files have no magic number. A size that matches the facet count in the header is binary
+        even if the header starts with 'solid' (some exporters do that), otherwise anything that doesnt start
+        like an ascii file ('solid' with a 'facet' soon after) is read as binary, so files with padding or a
+        wrong count still load */
+    bool isBinarySTL(const char* data, size_t length) {
+        if(length < 84)
+            return false;
 
-        // one space for all measurements, values are then copied into triFloat3 and put into Model
-        triFloat3Union preModel;
+        if(length == 84 + 50 * (size_t)readLittleEndian32(data + 80))
+            return true;
 
-        short_o attrs;
+        if(memcmp(data, "solid", 5) != 0)
+            return true;
 
-        for(int i = 0; i < intUnion.int_; i++) {
-            // read 3 floats into normal section of preModel
-            ifile.read(preModel.normal.x_.byte, 4);
-            ifile.read(preModel.normal.y_.byte, 4);
-            ifile.read(preModel.normal.z_.byte, 4);
+        const char* facet = "facet";
+        const char* end = data + std::min(length, (size_t)1024);
+        return std::search(data + 5, end, facet, facet + 5) == end;
+    }
 
-            // read 3 vectors into pts section of preModel
-            for(int j = 0; j < 3; j++) {
-                ifile.read(preModel.pts[j].x_.byte, 4);
-                ifile.read(preModel.pts[j].y_.byte, 4);
-                ifile.read(preModel.pts[j].z_.byte, 4);
-            }
+    /* number of whole facet records a binary .stl buffer really has, never more than the header says */
+    unsigned int getBinaryFacetCount(const char* data, size_t length) {
+        if(length < 84)
+            return 0;
+        return std::min(readLittleEndian32(data + 80), (unsigned int)std::min((length - 84) / 50, (size_t)0xFFFFFFFF));
+    }
+
+    /* same as parseFileBinary but for a file that is already in memory */
+    Model* parseBufferBinary(const char* data, size_t length, unsigned long long* hash = NULL) {
+
+        Model* myModel = new Model;
+        myModel->clear(); // STL::Model is just a vector
 
-            // read to chars to skip attribute section
-            ifile.read(attrs.byte, 2);
+        if(length < 84) {
+            std::cerr << "File too short to be a binary .stl" << std::endl;
+            if(hash != NULL)
+                *hash = finishHash(GEOMETRY_HASH_SEED, 0);
+            return myModel;
+        }
+
+        memcpy(header, data, 80); // header is 80 bytes of stuff we dont really care about
 
-            /* attrs.short_  = attrs.short_ >> 1; // last bit isnt important
-            preModel.r_ = 8.33f * (GLfloat)(attrs.short_ & 31);
-            attrs.short_  = attrs.short_ >> 5;
-            preModel.g_ = 8.33f * (GLfloat)(attrs.short_ & 31);
-            attrs.short_  = attrs.short_ >> 5;
-            preModel.b_ = 8.33f * (GLfloat)(attrs.short_ & 31);
-            // swap all bytes that need to be swapped
-            //swapTriFloat3Union(&preModel);
-            */
+        unsigned int numFacets = readLittleEndian32(data + 80);
 
-            myModel->push_back(packTriFloat3(&preModel));
+        std::cout << "Pre-sort: " << numFacets << std::endl;
 
+        // never read past the end of the buffer, whatever the header says
+        if(84 + 50 * (size_t)numFacets > length) {
+            std::cerr << "Facet count in header is larger than the file, only reading what is there" << std::endl;
+            numFacets = getBinaryFacetCount(data, length);
+        } else if(84 + 50 * (size_t)numFacets < length) {
+            std::cerr << "Warning: " << length - 84 - 50 * (size_t)numFacets << " bytes after the last facet, facet count in header may be wrong" << std::endl;
         }
 
-        ifile.close();
+        // records are converted a block at a time, values are then copied into triFloat3 and put into Model
+        const unsigned int blockFacets = 1024;
+        std::vector<GLfloat> values(12 * blockFacets);
+        myModel->reserve(numFacets);
+
+        for(unsigned int first = 0; first < numFacets; first += blockFacets) {
+            unsigned int count = std::min(blockFacets, numFacets - first);
+            unpackFacetRecords(data + 84 + (size_t)first * 50, count, &values[0]);
+
+            for(unsigned int i = 0; i < count; i++) {
+                // normal comes first, then 3 vectors
+                triFloat3* tf3 = new triFloat3;
+                memcpy(&tf3->normal, &values[i * 12], 12);
+                memcpy(tf3->pts, &values[i * 12 + 3], 36);
+                tf3->r_ = 0.0f;
+                tf3->g_ = 0.0f;
+                tf3->b_ = 0.0f;
+
+                myModel->push_back(tf3);
+            }
+        }
+
+        if(hash != NULL)
+            *hash = hashBinaryFacets(data + 84, numFacets);
 
         return myModel;
+    }
 
+    /* same as parseFileAscii but uses binary .stl files, the whole file is read at once */
+    Model* parseFileBinary(unsigned long long* hash = NULL) {
+
+        std::vector<char> buffer;
+        if(!readFileBuffer(_filename, &buffer)) {
+            std::cerr << "Invalid filename" << std::endl;
+            exit(1);
+        }
+
+        return parseBufferBinary(buffer.empty() ? NULL : &buffer[0], buffer.size(), hash);
+
+    }
+
+    /* deletes every facet and then the Model itself */
+    void freeModel(Model* myModel) {
+        for(unsigned int i = 0; i < myModel->size(); i++)
+            delete myModel->at(i);
+        delete myModel;
     }
 
     GLuint getBot(Model* myModel) {
@@ -337,55 +592,68 @@ namespace stl { // objectParser.hpp has many similarly named functions and so we
         return nrmcBot;
     }
 
-    objParse::GLfloat3* getAABB_Center(Model* myModel) {
-        objParse::GLfloat3 lesser;
-        objParse::GLfloat3 larger;
-        lesser.x_ = 1000000.0f; // start with a really big value that should only get smaller
-        lesser.y_ = 1000000.0f; // --
-        lesser.z_ = 1000000.0f; // --
-        larger.x_ = -1000000.0f; // start with a really small value that should only get larger
-        larger.y_ = -1000000.0f; // --
-        larger.z_ = -1000000.0f; // --
-
-        /* iterate through every point in every vertex to find largest and smallest xyz values */
+    /* iterate through every point in every vertex to find largest and smallest xyz values,
+        lesser and larger are only ever moved outward so several models can be measured together */
+    void growAABB(Model* myModel, objParse::GLfloat3* lesser, objParse::GLfloat3* larger) {
         for(unsigned int i = 0; i < myModel->size(); i++) {
             for(int j = 0; j < 3; j++) {
 
                 // test for low values
-                if(myModel->at(i)->pts[j].x_ < lesser.x_) {
-                    lesser.x_ = myModel->at(i)->pts[j].x_;
+                if(myModel->at(i)->pts[j].x_ < lesser->x_) {
+                    lesser->x_ = myModel->at(i)->pts[j].x_;
                 }
-                if(myModel->at(i)->pts[j].y_ < lesser.y_) {
-                    lesser.y_ = myModel->at(i)->pts[j].y_;
+                if(myModel->at(i)->pts[j].y_ < lesser->y_) {
+                    lesser->y_ = myModel->at(i)->pts[j].y_;
                 }
-                if(myModel->at(i)->pts[j].z_ < lesser.z_) {
-                    lesser.z_ = myModel->at(i)->pts[j].z_;
+                if(myModel->at(i)->pts[j].z_ < lesser->z_) {
+                    lesser->z_ = myModel->at(i)->pts[j].z_;
                 }
 
                 // test for high values
-                if(myModel->at(i)->pts[j].x_ > larger.x_) {
-                    larger.x_ = myModel->at(i)->pts[j].x_;
+                if(myModel->at(i)->pts[j].x_ > larger->x_) {
+                    larger->x_ = myModel->at(i)->pts[j].x_;
                 }
-                if(myModel->at(i)->pts[j].y_ > larger.y_) {
-                    larger.y_ = myModel->at(i)->pts[j].y_;
+                if(myModel->at(i)->pts[j].y_ > larger->y_) {
+                    larger->y_ = myModel->at(i)->pts[j].y_;
                 }
-                if(myModel->at(i)->pts[j].z_ > larger.z_) {
-                    larger.z_ = myModel->at(i)->pts[j].z_;
+                if(myModel->at(i)->pts[j].z_ > larger->z_) {
+                    larger->z_ = myModel->at(i)->pts[j].z_;
                 }
 
             }
         }
+    }
+
+    void startAABB(objParse::GLfloat3* lesser, objParse::GLfloat3* larger) {
+        lesser->x_ = 1000000.0f; // start with a really big value that should only get smaller
+        lesser->y_ = 1000000.0f; // --
+        lesser->z_ = 1000000.0f; // --
+        larger->x_ = -1000000.0f; // start with a really small value that should only get larger
+        larger->y_ = -1000000.0f; // --
+        larger->z_ = -1000000.0f; // --
+    }
 
+    objParse::GLfloat3* finishAABB_Center(objParse::GLfloat3* lesser, objParse::GLfloat3* larger) {
         objParse::GLfloat3* myFloat3 = new objParse::GLfloat3;
 
 
-        myFloat3->x_ = (lesser.x_ + larger.x_) / 2.0f; // mid x
-        myFloat3->y_ = (lesser.y_ + larger.y_) / 2.0f; // mid y
-        myFloat3->z_ = (lesser.z_ + larger.z_) / 2.0f; // mid z
+        myFloat3->x_ = (lesser->x_ + larger->x_) / 2.0f; // mid x
+        myFloat3->y_ = (lesser->y_ + larger->y_) / 2.0f; // mid y
+        myFloat3->z_ = (lesser->z_ + larger->z_) / 2.0f; // mid z
 
-        std::cout << "width: " << larger.x_ - lesser.x_ << " height: " << larger.y_ - lesser.y_ << " depth: " << larger.z_ - lesser.z_ << std::endl;
+        std::cout << "width: " << larger->x_ - lesser->x_ << " height: " << larger->y_ - lesser->y_ << " depth: " << larger->z_ - lesser->z_ << std::endl;
 
         return myFloat3;
+    }
+
+    objParse::GLfloat3* getAABB_Center(Model* myModel) {
+        objParse::GLfloat3 lesser;
+        objParse::GLfloat3 larger;
+
+        startAABB(&lesser, &larger);
+        growAABB(myModel, &lesser, &larger);
+
+        return finishAABB_Center(&lesser, &larger);
 
     }
 
@@ -409,42 +677,273 @@ namespace stl { // objectParser.hpp has many similarly named functions and so we
 
     /* returns a pointer to a new tf3 with the same data */
     triFloat3* getNewtf3(triFloat3* tf3_o) {
+        return new triFloat3(*tf3_o); // plain struct copy, stays in sync with triFloat3 by itself
+    }
+
+    /* combine many smaller models (possibly from differnt files) into one larger Model,
+        every facet is still copied into its own allocation so the result can be used like a parsed Model */
+    Model* packMultiModel(MultiModel* megaModel, int numThreads = 0) {
+        Model* myModel = new Model;
 
-        triFloat3* tf3_n = new triFloat3;
+        size_t total = 0;
+        for(unsigned int i = 0; i < megaModel->size(); i++)
+            total += megaModel->at(i)->size();
+        myModel->resize(total);
 
-        // copy vertex data over
-        for(int i = 0; i < 3; i++) {
-            tf3_n->pts[i].x_ = tf3_o->pts[i].x_;
-            tf3_n->pts[i].y_ = tf3_o->pts[i].y_;
-            tf3_n->pts[i].z_ = tf3_o->pts[i].z_;
+        size_t offset = 0;
+        for(unsigned int i = 0; i < megaModel->size(); i++) {
+            Model* part = megaModel->at(i);
+            parallelFor(0, part->size(), numThreads, [&](size_t first, size_t last) {
+                for(size_t j = first; j < last; j++)
+                    myModel->at(offset + j) = getNewtf3(part->at(j));
+            });
+            offset += part->size();
         }
 
-        // copy whatever colors there are over
-        tf3_n->r_ = tf3_o->r_;
-        tf3_n->g_ = tf3_o->g_;
-        tf3_n->b_ = tf3_o->b_;
+        return myModel;
+    }
 
-        // copy normal vector definitions over
-        tf3_n->normal.x_ = tf3_o->normal.x_;
-        tf3_n->normal.y_ = tf3_o->normal.y_;
-        tf3_n->normal.z_ = tf3_o->normal.z_;
+//-------------------------------------------------------------
+// merging without copying
+
+    /* several Models seen as one long Model, nothing is copied so the parts must outlive the view */
+    struct ModelView {
+        std::vector<Model*> parts;
+        std::vector<size_t> offsets; // index of the first facet of each part, last entry is the total
+
+        size_t size(void) const {
+            return offsets.back();
+        }
 
-        return tf3_n;
+        // finds the part holding facet i with a binary search, use the iterator for walking the whole view
+        triFloat3* at(size_t i) const {
+            size_t part = std::upper_bound(offsets.begin(), offsets.end(), i) - offsets.begin() - 1;
+            return parts[part]->at(i - offsets[part]);
+        }
+
+        struct iterator {
+            const ModelView* view;
+            size_t part;
+            size_t facet;
+
+            triFloat3* operator*(void) const {
+                return view->parts[part]->at(facet);
+            }
+
+            iterator& operator++(void) {
+                facet++;
+                while(part < view->parts.size() && facet >= view->parts[part]->size()) { // skips empty parts too
+                    part++;
+                    facet = 0;
+                }
+                return *this;
+            }
+
+            bool operator!=(const iterator& other) const {
+                return part != other.part || facet != other.facet;
+            }
+        };
+
+        iterator begin(void) const {
+            iterator it = { this, 0, 0 };
+            while(it.part < parts.size() && parts[it.part]->empty())
+                it.part++;
+            return it;
+        }
+
+        iterator end(void) const {
+            iterator it = { this, parts.size(), 0 };
+            return it;
+        }
+    };
+
+    /* lightweight alternative to packMultiModel, the view only stores the part pointers */
+    ModelView* getModelView(MultiModel* megaModel) {
+        ModelView* myView = new ModelView;
+        myView->parts = *megaModel;
+        myView->offsets.push_back(0);
+
+        for(unsigned int i = 0; i < megaModel->size(); i++)
+            myView->offsets.push_back(myView->offsets.back() + megaModel->at(i)->size());
+
+        return myView;
     }
 
-    /* combine many smaller models (possibly from differnt files) into one larger Model */
-    Model* packMultiModel(MultiModel* megaModel) {
-        Model* myModel = new Model;
+    objParse::GLfloat3* getAABB_Center(ModelView* myView) {
+        objParse::GLfloat3 lesser;
+        objParse::GLfloat3 larger;
 
-        for(unsigned int i = 0; i < megaModel->size(); i++) {
-            for(unsigned int j = 0; j < megaModel->at(i)->size(); j++) {
-                myModel->push_back(getNewtf3(megaModel->at(i)->at(j)));
+        startAABB(&lesser, &larger);
+        for(unsigned int i = 0; i < myView->parts.size(); i++)
+            growAABB(myView->parts[i], &lesser, &larger);
+
+        return finishAABB_Center(&lesser, &larger);
+    }
+
+    GLuint getBot(ModelView* myView) {
+
+        GLuint nrmcBot = glGenLists(1);
+
+        glNewList(nrmcBot, GL_COMPILE);
+        glBegin(GL_TRIANGLES);
+
+            for(ModelView::iterator it = myView->begin(); it != myView->end(); ++it) {
+                // all triangles will be green
+                glColor3f(0.0f, 1.0f, 0.0f);
+
+                for(int j = 0; j < 3; j++) {
+                    glVertex3f((*it)->pts[j].x_, (*it)->pts[j].y_, (*it)->pts[j].z_);
+                }
             }
+
+        glEnd();
+        glEndList();
+
+        return nrmcBot;
+    }
+
+    GLuint getWireframe(ModelView* myView) {
+        GLuint nrmcBot = glGenLists(1);
+
+        glNewList(nrmcBot, GL_COMPILE);
+        for(ModelView::iterator it = myView->begin(); it != myView->end(); ++it) {
+            glBegin(GL_LINE_LOOP);
+                glColor3f(0.0f, 0.0f, 0.0f);
+                for(int j = 0; j < 3; j++) {
+                    glVertex3f((*it)->pts[j].x_, (*it)->pts[j].y_, (*it)->pts[j].z_);
+                }
+            glEnd();
         }
+        glEndList();
+
+        return nrmcBot;
+    }
+
+//-------------------------------------------------------------
+// merging into one block
+
+    // every facet in one allocation instead of one allocation per facet
+    typedef std::vector<triFloat3> ContiguousModel;
+
+    /* single pre-sized copy of every part, split over numThreads threads (less than 1 uses every core) */
+    ContiguousModel* packMultiModelContiguous(MultiModel* megaModel, int numThreads = 0) {
+        ModelView* myView = getModelView(megaModel);
+        ContiguousModel* myModel = new ContiguousModel(myView->size());
+
+        parallelFor(0, myView->size(), numThreads, [&](size_t first, size_t last) {
+            // find where this range starts once, then walk the parts in order
+            size_t part = std::upper_bound(myView->offsets.begin(), myView->offsets.end(), first) - myView->offsets.begin() - 1;
+            size_t i = first;
+
+            while(i < last) {
+                Model* src = myView->parts[part];
+                size_t stop = std::min(last, myView->offsets[part + 1]);
+                for(; i < stop; i++)
+                    (*myModel)[i] = *src->at(i - myView->offsets[part]);
+                part++;
+            }
+        });
 
+        delete myView;
         return myModel;
     }
 
+    GLuint getBot(ContiguousModel* myModel) {
+
+        GLuint nrmcBot = glGenLists(1);
+
+        glNewList(nrmcBot, GL_COMPILE);
+        glBegin(GL_TRIANGLES);
+
+            for(unsigned int i = 0; i < myModel->size(); i++) {
+                // all triangles will be green
+                glColor3f(0.0f, 1.0f, 0.0f);
+
+                for(int j = 0; j < 3; j++) {
+                    glVertex3f((*myModel)[i].pts[j].x_, (*myModel)[i].pts[j].y_, (*myModel)[i].pts[j].z_);
+                }
+            }
+
+        glEnd();
+        glEndList();
+
+        return nrmcBot;
+    }
+
+    // hashing for exact vertex positions, used to weld facets into an IndexedMesh
+    struct GLfloat3Hash {
+        size_t operator()(const objParse::GLfloat3& v) const {
+            unsigned int bits[3];
+            memcpy(bits, &v, sizeof(bits));
+
+            size_t h = bits[0];
+            h = h * 0x9E3779B1u ^ bits[1];
+            h = h * 0x9E3779B1u ^ bits[2];
+            return h;
+        }
+    };
+
+    struct GLfloat3Equal {
+        bool operator()(const objParse::GLfloat3& a, const objParse::GLfloat3& b) const {
+            return a.x_ == b.x_ && a.y_ == b.y_ && a.z_ == b.z_;
+        }
+    };
+
+    /* turns a Model into an IndexedMesh, facet corners with exactly the same position share one vertex */
+    IndexedMesh* indexModel(Model* myModel) {
+        IndexedMesh* myMesh = new IndexedMesh;
+        myMesh->indices.resize(myModel->size() * 3);
+        myMesh->normals.resize(myModel->size());
+
+        std::unordered_map<objParse::GLfloat3, unsigned int, GLfloat3Hash, GLfloat3Equal> welded;
+        welded.reserve(myModel->size() / 2 + 1); // closed meshes have about half as many vertices as facets
+
+        for(unsigned int i = 0; i < myModel->size(); i++) {
+            triFloat3* tf3 = myModel->at(i);
+            myMesh->normals[i] = tf3->normal;
+
+            for(int j = 0; j < 3; j++) {
+                objParse::GLfloat3 v = tf3->pts[j];
+                v.x_ += 0.0f; // turns -0.0 into 0.0 so both weld together
+                v.y_ += 0.0f;
+                v.z_ += 0.0f;
+
+                std::pair<std::unordered_map<objParse::GLfloat3, unsigned int, GLfloat3Hash, GLfloat3Equal>::iterator, bool> found =
+                        welded.insert(std::make_pair(v, (unsigned int)myMesh->verts.size()));
+                if(found.second)
+                    myMesh->verts.push_back(v);
+
+                myMesh->indices[i * 3 + j] = found.first->second;
+            }
+        }
+
+        std::cout << "Welded " << myModel->size() * 3 << " corners into " << myMesh->verts.size() << " vertices" << std::endl;
+
+        return myMesh;
+    }
+
+    /* same as getBot but draws from the vertex and index arrays of an IndexedMesh */
+    GLuint getBot(IndexedMesh* myMesh) {
+
+        GLuint nrmcBot = glGenLists(1);
+
+        glNewList(nrmcBot, GL_COMPILE);
+
+            // all triangles will be green
+            glColor3f(0.0f, 1.0f, 0.0f);
+
+            if(!myMesh->indices.empty()) {
+                glEnableClientState(GL_VERTEX_ARRAY);
+                glVertexPointer(3, GL_FLOAT, sizeof(objParse::GLfloat3), &myMesh->verts[0]);
+                glDrawElements(GL_TRIANGLES, (GLsizei)myMesh->indices.size(), GL_UNSIGNED_INT, &myMesh->indices[0]);
+                glDisableClientState(GL_VERTEX_ARRAY);
+            }
+
+        glEndList();
+
+        return nrmcBot;
+    }
+
 }
 
 #endif // __JJC_STL_PARSER_HPP__
@@ -0,0 +1,233 @@
+/*
+    STL-Registry, shared geometry for assemblies that reuse the same parts
+    Copyright (C) 2026  STL-Parser contributors
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Author(s):
+        STL-Parser contributors
+
+    File Type: header/implementation, STL-Registry
+
+    Date Created: 10/18/2026
+
+    Date Last Modified: 10/18/2026
+
+    Purpose:
+        Loads .stl files as instances of shared geometry
+        Every mesh is fingerprinted (stl::hashBinaryFacets / the hash output of the parsers),
+        files with the same facets share one Model and one display list and only keep their own transform
+        Binary files are hashed straight from the file buffer so duplicates are never parsed at all
+        The hash only finds candidates, a mesh is only shared after its facets compare equal bit for bit,
+        meshes whose hashes collide are kept side by side under the same key
+
+*/
+
+#ifndef __JJC_STL_REGISTRY_HPP__
+#define __JJC_STL_REGISTRY_HPP__
+
+#include <STL-Parser.hpp>
+#include <STL-Transform.hpp>
+
+#include <string.h>
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+namespace stl {
+
+    // one unique mesh, shared by every instance that uses it
+    struct Geometry {
+        Model* model;
+        GLuint list; // made the first time an instance is drawn, 0 until then
+        unsigned long long hash;
+        int refs;    // number of instances using this geometry
+    };
+
+    struct Instance {
+        Geometry* geometry;
+        GLmatrix4 transform; // applied with glMultMatrixf before the shared list is called
+    };
+
+    struct GeometryRegistry {
+        std::unordered_multimap<unsigned long long, Geometry*> byHash; // more than one entry per key only if hashes collide
+        std::unordered_map<std::string, Geometry*> byPath; // files we have already seen, skips even reading them (files are assumed not to change)
+        std::vector<Instance*> instances;
+    };
+
+    /* true if myModel has exactly these binary .stl records (normal and corners, same bytes, attribute bytes ignored) */
+    bool isSameGeometry(Model* myModel, const char* facets, unsigned int numFacets) {
+        if(myModel->size() != numFacets)
+            return false;
+
+        for(unsigned int i = 0; i < numFacets; i++) {
+            char record[48];
+            memcpy(record, &myModel->at(i)->normal, 12);
+            memcpy(record + 12, myModel->at(i)->pts, 36);
+            convertLittleEndian32(record, record, 12);
+            if(memcmp(record, facets + (size_t)i * 50, 48) != 0)
+                return false;
+        }
+        return true;
+    }
+
+    bool isSameGeometry(Model* a, Model* b) {
+        if(a->size() != b->size())
+            return false;
+
+        for(unsigned int i = 0; i < a->size(); i++) {
+            if(memcmp(&a->at(i)->normal, &b->at(i)->normal, sizeof(a->at(i)->normal)) != 0)
+                return false;
+            if(memcmp(a->at(i)->pts, b->at(i)->pts, sizeof(a->at(i)->pts)) != 0)
+                return false;
+        }
+        return true;
+    }
+
+    /* geometry with this hash whose facets really are the given ones, NULL if there is none */
+    Geometry* findGeometry(GeometryRegistry* registry, unsigned long long hash, const char* facets, unsigned int numFacets) {
+        typedef std::unordered_multimap<unsigned long long, Geometry*>::iterator HashIterator;
+        std::pair<HashIterator, HashIterator> range = registry->byHash.equal_range(hash);
+        for(HashIterator it = range.first; it != range.second; ++it) {
+            if(isSameGeometry(it->second->model, facets, numFacets))
+                return it->second;
+        }
+        return NULL;
+    }
+
+    Geometry* findGeometry(GeometryRegistry* registry, unsigned long long hash, Model* myModel) {
+        typedef std::unordered_multimap<unsigned long long, Geometry*>::iterator HashIterator;
+        std::pair<HashIterator, HashIterator> range = registry->byHash.equal_range(hash);
+        for(HashIterator it = range.first; it != range.second; ++it) {
+            if(isSameGeometry(it->second->model, myModel))
+                return it->second;
+        }
+        return NULL;
+    }
+
+    /* loads filename (binary or ascii) as a new instance with the given transform,
+        geometry that is already in the registry is reused instead of being parsed again */
+    Instance* loadInstance(GeometryRegistry* registry, char* filename, const GLmatrix4& transform) {
+        Geometry* geometry = NULL;
+
+        std::unordered_map<std::string, Geometry*>::iterator known = registry->byPath.find(filename);
+        if(known != registry->byPath.end())
+            geometry = known->second;
+
+        if(geometry == NULL) {
+            std::vector<char> buffer;
+            if(!readFileBuffer(filename, &buffer)) {
+                std::cerr << "Invalid filename" << std::endl;
+                exit(1);
+            }
+
+            const char* data = buffer.empty() ? NULL : &buffer[0];
+            unsigned long long hash;
+            Model* myModel = NULL;
+
+            if(isBinarySTL(data, buffer.size())) {
+                // fingerprint first, only parse meshes we havent seen before
+                unsigned int numFacets = getBinaryFacetCount(data, buffer.size());
+                hash = hashBinaryFacets(data + 84, numFacets);
+                geometry = findGeometry(registry, hash, data + 84, numFacets);
+                if(geometry == NULL)
+                    myModel = parseBufferBinary(data, buffer.size());
+            } else {
+                openFile(filename);
+                myModel = parseFileAscii(&hash);
+                geometry = findGeometry(registry, hash, myModel);
+                if(geometry != NULL)
+                    freeModel(myModel); // ascii files have to be parsed to be hashed, throw away the copy
+            }
+
+            if(geometry != NULL) {
+                std::cout << "Reusing geometry for " << filename << std::endl;
+            } else {
+                geometry = new Geometry;
+                geometry->model = myModel;
+                geometry->list = 0;
+                geometry->hash = hash;
+                geometry->refs = 0;
+                registry->byHash.insert(std::make_pair(hash, geometry));
+            }
+
+            registry->byPath[filename] = geometry;
+        }
+
+        Instance* myInstance = new Instance;
+        myInstance->geometry = geometry;
+        myInstance->transform = transform;
+        geometry->refs++;
+
+        registry->instances.push_back(myInstance);
+        return myInstance;
+    }
+
+    /* removes an instance, its geometry (and display list) is freed once nothing uses it */
+    void releaseInstance(GeometryRegistry* registry, Instance* myInstance) {
+        Geometry* geometry = myInstance->geometry;
+
+        for(unsigned int i = 0; i < registry->instances.size(); i++) {
+            if(registry->instances[i] == myInstance) {
+                registry->instances.erase(registry->instances.begin() + i);
+                break;
+            }
+        }
+        delete myInstance;
+
+        if(--geometry->refs > 0)
+            return;
+
+        // forget every path that pointed at this geometry
+        std::unordered_map<std::string, Geometry*>::iterator it = registry->byPath.begin();
+        while(it != registry->byPath.end()) {
+            if(it->second == geometry)
+                it = registry->byPath.erase(it);
+            else
+                ++it;
+        }
+        typedef std::unordered_multimap<unsigned long long, Geometry*>::iterator HashIterator;
+        std::pair<HashIterator, HashIterator> range = registry->byHash.equal_range(geometry->hash);
+        for(HashIterator h = range.first; h != range.second; ++h) {
+            if(h->second == geometry) {
+                registry->byHash.erase(h);
+                break;
+            }
+        }
+
+        if(geometry->list != 0)
+            glDeleteLists(geometry->list, 1);
+        freeModel(geometry->model);
+        delete geometry;
+    }
+
+    void drawInstance(Instance* myInstance) {
+        Geometry* geometry = myInstance->geometry;
+        if(geometry->list == 0)
+            geometry->list = getBot(geometry->model);
+
+        glPushMatrix();
+        glMultMatrixf(myInstance->transform.m);
+        glCallList(geometry->list);
+        glPopMatrix();
+    }
+
+    /* draws every instance in the registry, each unique mesh is only ever compiled once */
+    void drawInstances(GeometryRegistry* registry) {
+        for(unsigned int i = 0; i < registry->instances.size(); i++)
+            drawInstance(registry->instances[i]);
+    }
+
+}
+
+#endif // __JJC_STL_REGISTRY_HPP__
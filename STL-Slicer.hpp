@@ -0,0 +1,291 @@
+/*
+    STL-Slicer, planar cross sections of STL-Parser models
+    Copyright (C) 2026  STL-Parser contributors
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Author(s):
+        STL-Parser contributors
+
+    File Type: header/implementation, STL-Slicer
+
+    Date Created: 10/18/2026
+
+    Date Last Modified: 10/18/2026
+
+    Purpose:
+        Cuts a model with evenly spaced planes of constant z (for additive manufacturing prep)
+        Every triangle is bucketed once into the layers its z range covers, then the layers are
+        cut on all cores and the segments of each layer are chained into polylines by hashing their endpoints
+
+    Misc. Notes:
+        Layer k is at z = zmin + layerHeight * (k + 0.5), the middle of each printed layer
+        Loops around solid material run counter-clockwise seen from +z, holes run clockwise
+        (this uses the facet winding, not the stored normals, so bad normals in the file dont matter)
+
+*/
+
+#ifndef __JJC_STL_SLICER_HPP__
+#define __JJC_STL_SLICER_HPP__
+
+#include <STL-Parser.hpp>
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <unordered_map>
+#include <math.h>
+#include <float.h>
+
+namespace stl {
+
+    struct SlicePoint {
+        GLfloat x_;
+        GLfloat y_;
+    };
+
+    struct SlicePolyline {
+        std::vector<SlicePoint> pts;
+        bool closed; // false when the mesh has holes and the chain ran into an open edge
+    };
+
+    struct SliceLayer {
+        GLfloat z;
+        std::vector<SlicePolyline> loops;
+    };
+
+    struct SliceSegment {
+        SlicePoint a;
+        SlicePoint b;
+    };
+
+    /* where the edge p-q crosses height z, the endpoints are put in a fixed order first so both triangles
+        sharing the edge get exactly the same bits back (that is what lets the chaining use exact hashing) */
+    SlicePoint edgeCrossing(const objParse::GLfloat3& p, const objParse::GLfloat3& q, GLfloat z) {
+        const objParse::GLfloat3* lo = &p;
+        const objParse::GLfloat3* hi = &q;
+        if(q.z_ < p.z_ || (q.z_ == p.z_ && (q.x_ < p.x_ || (q.x_ == p.x_ && q.y_ < p.y_))))
+            std::swap(lo, hi);
+
+        GLfloat t = (z - lo->z_) / (hi->z_ - lo->z_);
+        SlicePoint r;
+        r.x_ = lo->x_ + t * (hi->x_ - lo->x_) + 0.0f; // + 0.0f folds -0.0 into 0.0 for hashing
+        r.y_ = lo->y_ + t * (hi->y_ - lo->y_) + 0.0f;
+        return r;
+    }
+
+    /* segment where the plane at z cuts tri, returns false if the triangle doesnt cross the plane.
+        corners exactly on the plane count as below it so every edge is either crossed once or not at all */
+    bool sliceTriangle(const objParse::GLfloat3* tri, GLfloat z, SliceSegment* seg) {
+        bool above[3];
+        int numAbove = 0;
+        for(int i = 0; i < 3; i++) {
+            above[i] = tri[i].z_ > z;
+            numAbove += above[i] ? 1 : 0;
+        }
+        if(numAbove == 0 || numAbove == 3)
+            return false;
+
+        // the lone corner is on the other side from the other two, its two edges are the crossed ones
+        int lone = 0;
+        for(int i = 0; i < 3; i++) {
+            if(above[i] == (numAbove == 1))
+                lone = i;
+        }
+        const objParse::GLfloat3& v0 = tri[lone];
+        const objParse::GLfloat3& v1 = tri[(lone + 1) % 3];
+        const objParse::GLfloat3& v2 = tri[(lone + 2) % 3];
+
+        SlicePoint p = edgeCrossing(v0, v1, z);
+        SlicePoint q = edgeCrossing(v0, v2, z);
+
+        // walking from the v0-v1 crossing to the v0-v2 crossing keeps the inside on the left when
+        // v0 is above, so flip it when v0 is the lone corner below
+        if(above[lone]) {
+            seg->a = p;
+            seg->b = q;
+        } else {
+            seg->a = q;
+            seg->b = p;
+        }
+
+        return !(seg->a.x_ == seg->b.x_ && seg->a.y_ == seg->b.y_);
+    }
+
+    inline unsigned long long slicePointKey(const SlicePoint& p) {
+        unsigned int bits[2];
+        memcpy(bits, &p, sizeof(bits));
+        return ((unsigned long long)bits[0] << 32) | bits[1];
+    }
+
+    /* joins the directed segments of one layer into polylines, head to tail */
+    void chainSegments(std::vector<SliceSegment>* segs, std::vector<SlicePolyline>* loops) {
+        std::unordered_map<unsigned long long, int> byStart;
+        std::unordered_map<unsigned long long, int> byEnd;
+        byStart.reserve(segs->size());
+        byEnd.reserve(segs->size());
+
+        for(unsigned int i = 0; i < segs->size(); i++) {
+            byStart.insert(std::make_pair(slicePointKey(segs->at(i).a), (int)i));
+            byEnd.insert(std::make_pair(slicePointKey(segs->at(i).b), (int)i));
+        }
+
+        std::vector<char> used(segs->size(), 0);
+
+        // open chains first (a start nothing leads into), whatever is left over only forms loops
+        for(int pass = 0; pass < 2; pass++) {
+            for(unsigned int i = 0; i < segs->size(); i++) {
+                if(used[i])
+                    continue;
+                if(pass == 0 && byEnd.find(slicePointKey(segs->at(i).a)) != byEnd.end())
+                    continue;
+
+                SlicePolyline line;
+                line.closed = false;
+                line.pts.push_back(segs->at(i).a);
+
+                int cur = (int)i;
+                while(true) {
+                    used[cur] = 1;
+                    const SlicePoint& end = segs->at(cur).b;
+
+                    if(end.x_ == segs->at(i).a.x_ && end.y_ == segs->at(i).a.y_) {
+                        line.closed = true; // back where we started, the first point isnt repeated
+                        break;
+                    }
+                    line.pts.push_back(end);
+
+                    std::unordered_map<unsigned long long, int>::iterator next = byStart.find(slicePointKey(end));
+                    if(next == byStart.end() || used[next->second])
+                        break;
+                    cur = next->second;
+                }
+
+                loops->push_back(line);
+            }
+        }
+    }
+
+    /* cuts the model every layerHeight along z and returns the outline of every layer,
+        the work is split over numThreads threads (less than 1 uses every core) */
+    std::vector<SliceLayer>* sliceModel(Model* myModel, GLfloat layerHeight, int numThreads = 0) {
+        std::vector<SliceLayer>* layers = new std::vector<SliceLayer>;
+        unsigned int numTris = myModel->size();
+        if(numTris == 0 || layerHeight <= 0.0f)
+            return layers;
+
+        // flat copy of the triangles, the per-layer passes read these many times
+        std::vector<objParse::GLfloat3> tris(numTris * 3);
+        GLfloat zmin = FLT_MAX;
+        GLfloat zmax = -FLT_MAX;
+        for(unsigned int i = 0; i < numTris; i++) {
+            for(int j = 0; j < 3; j++) {
+                tris[i * 3 + j] = myModel->at(i)->pts[j];
+                zmin = std::min(zmin, myModel->at(i)->pts[j].z_);
+                zmax = std::max(zmax, myModel->at(i)->pts[j].z_);
+            }
+        }
+
+        GLfloat firstZ = zmin + 0.5f * layerHeight;
+        int numLayers = (int)floor((zmax - firstZ) / layerHeight) + 1;
+        if(numLayers <= 0)
+            return layers;
+
+        layers->resize(numLayers);
+        for(int k = 0; k < numLayers; k++)
+            layers->at(k).z = firstZ + layerHeight * k;
+
+        // layers [first, last] each triangle might cross
+        std::vector<int> firstLayer(numTris);
+        std::vector<int> lastLayer(numTris);
+
+        int threads = getNumThreads(numThreads);
+        unsigned int chunk = (numTris + threads - 1) / threads;
+
+        // count how many triangles each thread will put in each layer, then fill without any locking
+        std::vector<std::vector<unsigned int> > counts(threads, std::vector<unsigned int>(numLayers, 0));
+        std::vector<std::thread> workers;
+
+        for(int t = 0; t < threads; t++) {
+            workers.push_back(std::thread([&, t]() {
+                unsigned int begin = std::min(numTris, t * chunk);
+                unsigned int end = std::min(numTris, begin + chunk);
+                for(unsigned int i = begin; i < end; i++) {
+                    GLfloat lo = std::min(tris[i * 3].z_, std::min(tris[i * 3 + 1].z_, tris[i * 3 + 2].z_));
+                    GLfloat hi = std::max(tris[i * 3].z_, std::max(tris[i * 3 + 1].z_, tris[i * 3 + 2].z_));
+                    int k0 = std::max(0, (int)ceil((lo - firstZ) / layerHeight));
+                    int k1 = std::min(numLayers - 1, (int)floor((hi - firstZ) / layerHeight));
+                    firstLayer[i] = k0;
+                    lastLayer[i] = k1;
+                    for(int k = k0; k <= k1; k++)
+                        counts[t][k]++;
+                }
+            }));
+        }
+        for(int t = 0; t < threads; t++)
+            workers[t].join();
+        workers.clear();
+
+        std::vector<size_t> layerStart(numLayers + 1, 0);
+        for(int k = 0; k < numLayers; k++) {
+            size_t total = layerStart[k];
+            for(int t = 0; t < threads; t++) {
+                unsigned int c = counts[t][k];
+                counts[t][k] = (unsigned int)(total - layerStart[k]); // becomes the thread's offset inside the layer
+                total += c;
+            }
+            layerStart[k + 1] = total;
+        }
+
+        std::vector<unsigned int> buckets(layerStart[numLayers]);
+        for(int t = 0; t < threads; t++) {
+            workers.push_back(std::thread([&, t]() {
+                unsigned int begin = std::min(numTris, t * chunk);
+                unsigned int end = std::min(numTris, begin + chunk);
+                for(unsigned int i = begin; i < end; i++) {
+                    for(int k = firstLayer[i]; k <= lastLayer[i]; k++)
+                        buckets[layerStart[k] + counts[t][k]++] = i;
+                }
+            }));
+        }
+        for(int t = 0; t < threads; t++)
+            workers[t].join();
+        workers.clear();
+
+        // layers take very different amounts of work, so threads grab them one at a time
+        std::atomic<int> nextLayer(0);
+        for(int t = 0; t < threads; t++) {
+            workers.push_back(std::thread([&]() {
+                std::vector<SliceSegment> segs;
+                int k;
+                while((k = nextLayer++) < numLayers) {
+                    GLfloat z = layers->at(k).z;
+                    segs.clear();
+                    for(size_t b = layerStart[k]; b < layerStart[k + 1]; b++) {
+                        SliceSegment seg;
+                        if(sliceTriangle(&tris[buckets[b] * 3], z, &seg))
+                            segs.push_back(seg);
+                    }
+                    chainSegments(&segs, &layers->at(k).loops);
+                }
+            }));
+        }
+        for(int t = 0; t < threads; t++)
+            workers[t].join();
+
+        return layers;
+    }
+
+}
+
+#endif // __JJC_STL_SLICER_HPP__
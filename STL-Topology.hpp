@@ -0,0 +1,297 @@
+/*
+    STL-Topology, edge adjacency and mesh validation for STL-Parser models
+    Copyright (C) 2026  STL-Parser contributors
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Author(s):
+        STL-Parser contributors
+
+    File Type: header/implementation, STL-Topology
+
+    Date Created: 10/18/2026
+
+    Date Last Modified: 10/18/2026
+
+    Purpose:
+        Builds half-edge twins for a welded mesh (stl::indexModel) and checks it for the usual .stl problems:
+        open boundaries, non-manifold edges, neighbours with opposite winding, duplicate and degenerate facets,
+        and counts the connected pieces
+        Edges are matched by sorting them (objParse::parallelSort) instead of hashing, which keeps memory
+        flat and splits well over threads for very large meshes
+
+    Misc. Notes:
+        Half-edge h belongs to triangle h / 3 and runs from indices[h] to indices[nextHalfEdge(h)]
+
+*/
+
+#ifndef __JJC_STL_TOPOLOGY_HPP__
+#define __JJC_STL_TOPOLOGY_HPP__
+
+#include <STL-Parser.hpp>
+
+#include <vector>
+#include <atomic>
+#include <algorithm>
+
+namespace stl {
+
+    // bits in MeshTopology::facetFlags
+    const unsigned char FACET_DEGENERATE = 0x01; // repeated corner or zero area
+    const unsigned char FACET_DUPLICATE  = 0x02; // same corners as an earlier facet (in any order)
+    const unsigned char FACET_NONMANIFOLD = 0x04; // touches an edge shared by more than 2 facets
+    const unsigned char FACET_BOUNDARY   = 0x08; // has an edge with no neighbour
+    const unsigned char FACET_FLIPPED    = 0x10; // has a neighbour wound the other way
+
+    struct MeshTopology {
+        IndexedMesh* mesh;            // mesh this was built from, not owned
+        std::vector<int> twin;        // opposite half-edge, -1 for boundary, non-manifold and degenerate edges
+        std::vector<int> component;   // piece each triangle belongs to, numbered from 0
+        std::vector<unsigned char> facetFlags;
+        int numComponents;
+
+        unsigned int boundaryEdges;
+        unsigned int nonManifoldEdges;
+        unsigned int flippedEdges;    // shared edges where both facets run the same direction
+        unsigned int degenerateFacets;
+        unsigned int duplicateFacets;
+    };
+
+    inline unsigned int nextHalfEdge(unsigned int h) {
+        return (h % 3 == 2) ? h - 2 : h + 1;
+    }
+
+    /* triangle on the other side of edge (0 to 2) of tri, -1 if there isnt exactly one */
+    inline int getNeighbor(MeshTopology* topo, unsigned int tri, int edge) {
+        int t = topo->twin[tri * 3 + edge];
+        return (t < 0) ? -1 : t / 3;
+    }
+
+    /* true if the mesh is closed, manifold and consistently wound (a valid solid) */
+    inline bool isWatertight(MeshTopology* topo) {
+        return topo->boundaryEdges == 0 && topo->nonManifoldEdges == 0 && topo->flippedEdges == 0;
+    }
+
+    struct TopoEdgeKey {
+        unsigned long long key; // smaller vertex in the high half, larger in the low half
+        unsigned int halfEdge;
+
+        bool operator<(const TopoEdgeKey& rhs) const {
+            return (key != rhs.key) ? key < rhs.key : halfEdge < rhs.halfEdge;
+        }
+    };
+
+    struct TopoFacetKey {
+        unsigned int v[3]; // corners in ascending order
+        unsigned int tri;
+
+        bool operator<(const TopoFacetKey& rhs) const {
+            if(v[0] != rhs.v[0]) return v[0] < rhs.v[0];
+            if(v[1] != rhs.v[1]) return v[1] < rhs.v[1];
+            if(v[2] != rhs.v[2]) return v[2] < rhs.v[2];
+            return tri < rhs.tri;
+        }
+    };
+
+    int findRoot(std::vector<int>& parent, int i) {
+        while(parent[i] != i) {
+            parent[i] = parent[parent[i]]; // path halving
+            i = parent[i];
+        }
+        return i;
+    }
+
+    /* moves begin forward past the rest of a run of equal edges so no run is split between two ranges */
+    size_t alignToEdgeRun(std::vector<TopoEdgeKey>& edges, size_t begin) {
+        while(begin > 0 && begin < edges.size() && edges[begin].key == edges[begin - 1].key)
+            begin++;
+        return begin;
+    }
+
+    /* builds twins for every half-edge of myMesh and validates it, numThreads less than 1 uses every core */
+    MeshTopology* buildTopology(IndexedMesh* myMesh, int numThreads = 0) {
+        MeshTopology* topo = new MeshTopology;
+        unsigned int numTris = myMesh->indices.size() / 3;
+        const unsigned int* indices = myMesh->indices.empty() ? NULL : &myMesh->indices[0];
+
+        topo->mesh = myMesh;
+        topo->twin.assign(numTris * 3, -1);
+        topo->facetFlags.assign(numTris, 0);
+        topo->component.resize(numTris);
+
+        std::atomic<unsigned int> degenerate(0);
+        std::atomic<unsigned int> boundary(0);
+        std::atomic<unsigned int> nonManifold(0);
+        std::atomic<unsigned int> flipped(0);
+
+        // degenerate facets and their sorted corners for finding duplicates
+        std::vector<TopoFacetKey> facets(numTris);
+        parallelFor(0, numTris, numThreads, [&](size_t first, size_t last) {
+            unsigned int count = 0;
+            for(size_t i = first; i < last; i++) {
+                unsigned int a = indices[i * 3];
+                unsigned int b = indices[i * 3 + 1];
+                unsigned int c = indices[i * 3 + 2];
+
+                const objParse::GLfloat3& p = myMesh->verts[a];
+                const objParse::GLfloat3& q = myMesh->verts[b];
+                const objParse::GLfloat3& r = myMesh->verts[c];
+                GLfloat e1[3] = { q.x_ - p.x_, q.y_ - p.y_, q.z_ - p.z_ };
+                GLfloat e2[3] = { r.x_ - p.x_, r.y_ - p.y_, r.z_ - p.z_ };
+                GLfloat nx = e1[1] * e2[2] - e1[2] * e2[1];
+                GLfloat ny = e1[2] * e2[0] - e1[0] * e2[2];
+                GLfloat nz = e1[0] * e2[1] - e1[1] * e2[0];
+
+                if(a == b || b == c || a == c || (nx == 0.0f && ny == 0.0f && nz == 0.0f)) {
+                    topo->facetFlags[i] |= FACET_DEGENERATE;
+                    count++;
+                }
+
+                if(a > b) std::swap(a, b);
+                if(b > c) std::swap(b, c);
+                if(a > b) std::swap(a, b);
+                facets[i].v[0] = a;
+                facets[i].v[1] = b;
+                facets[i].v[2] = c;
+                facets[i].tri = (unsigned int)i;
+            }
+            degenerate += count;
+        });
+
+        parallelSort(&facets, numThreads);
+
+        // the first facet of each run is kept, the rest are duplicates (sort puts the lowest index first)
+        unsigned int duplicates = 0;
+        for(unsigned int i = 1; i < numTris; i++) {
+            if(facets[i].v[0] == facets[i - 1].v[0] && facets[i].v[1] == facets[i - 1].v[1] && facets[i].v[2] == facets[i - 1].v[2]) {
+                topo->facetFlags[facets[i].tri] |= FACET_DUPLICATE;
+                duplicates++;
+            }
+        }
+        std::vector<TopoFacetKey>().swap(facets);
+
+        // every half-edge keyed by its undirected edge, equal keys end up next to each other after sorting
+        std::vector<TopoEdgeKey> edges(numTris * 3);
+        parallelFor(0, numTris * 3, numThreads, [&](size_t first, size_t last) {
+            for(size_t h = first; h < last; h++) {
+                unsigned long long a = indices[h];
+                unsigned long long b = indices[nextHalfEdge((unsigned int)h)];
+                edges[h].key = (a < b) ? (a << 32) | b : (b << 32) | a;
+                edges[h].halfEdge = (unsigned int)h;
+            }
+        });
+
+        parallelSort(&edges, numThreads);
+
+        // walk runs of the same edge, ranges start on a run boundary so each run is seen by one thread only.
+        // results go in edgeFlags first, every half-edge is in exactly one run so only one thread ever writes
+        // its byte (the three edges of a triangle can land in different ranges, so facetFlags cant be used here)
+        std::vector<unsigned char> edgeFlags(numTris * 3, 0);
+        parallelFor(0, edges.size(), numThreads, [&](size_t first, size_t last) {
+            unsigned int myBoundary = 0;
+            unsigned int myNonManifold = 0;
+            unsigned int myFlipped = 0;
+
+            size_t i = alignToEdgeRun(edges, first);
+            last = alignToEdgeRun(edges, last);
+
+            while(i < last) {
+                size_t run = i + 1;
+                while(run < edges.size() && edges[run].key == edges[i].key)
+                    run++;
+
+                unsigned int h0 = edges[i].halfEdge;
+                unsigned int count = (unsigned int)(run - i);
+
+                if((edges[i].key >> 32) == (edges[i].key & 0xFFFFFFFFULL)) {
+                    // collapsed edge of a degenerate facet, already reported
+                } else if(count == 1) {
+                    edgeFlags[h0] = FACET_BOUNDARY;
+                    myBoundary++;
+                } else if(count == 2) {
+                    unsigned int h1 = edges[i + 1].halfEdge;
+                    topo->twin[h0] = (int)h1;
+                    topo->twin[h1] = (int)h0;
+
+                    // consistently wound neighbours run the shared edge in opposite directions
+                    if(indices[h0] == indices[h1]) {
+                        edgeFlags[h0] = FACET_FLIPPED;
+                        edgeFlags[h1] = FACET_FLIPPED;
+                        myFlipped++;
+                    }
+                } else {
+                    for(size_t j = i; j < run; j++)
+                        edgeFlags[edges[j].halfEdge] = FACET_NONMANIFOLD;
+                    myNonManifold++;
+                }
+
+                i = run;
+            }
+
+            boundary += myBoundary;
+            nonManifold += myNonManifold;
+            flipped += myFlipped;
+        }, 65536);
+
+        // each triangle picks up the flags of its own three edges
+        parallelFor(0, numTris, numThreads, [&](size_t first, size_t last) {
+            for(size_t i = first; i < last; i++)
+                topo->facetFlags[i] |= edgeFlags[i * 3] | edgeFlags[i * 3 + 1] | edgeFlags[i * 3 + 2];
+        });
+        std::vector<unsigned char>().swap(edgeFlags);
+
+        // connected pieces, every facet on the same edge (even a non-manifold one) is in the same piece
+        std::vector<int> parent(numTris);
+        for(unsigned int i = 0; i < numTris; i++)
+            parent[i] = (int)i;
+
+        for(size_t i = 1; i < edges.size(); i++) {
+            if(edges[i].key != edges[i - 1].key)
+                continue;
+            int a = findRoot(parent, edges[i].halfEdge / 3);
+            int b = findRoot(parent, edges[i - 1].halfEdge / 3);
+            if(a != b)
+                parent[std::max(a, b)] = std::min(a, b);
+        }
+        std::vector<TopoEdgeKey>().swap(edges);
+
+        topo->numComponents = 0;
+        for(unsigned int i = 0; i < numTris; i++) {
+            int root = findRoot(parent, i);
+            if(root == (int)i)
+                topo->component[i] = topo->numComponents++;
+            else
+                topo->component[i] = topo->component[root]; // roots are always the lowest triangle of a piece
+        }
+
+        topo->boundaryEdges = boundary;
+        topo->nonManifoldEdges = nonManifold;
+        topo->flippedEdges = flipped;
+        topo->degenerateFacets = degenerate;
+        topo->duplicateFacets = duplicates;
+
+        return topo;
+    }
+
+    void printTopologyReport(MeshTopology* topo) {
+        std::cout << "Components: " << topo->numComponents << std::endl;
+        std::cout << "Boundary edges: " << topo->boundaryEdges << std::endl;
+        std::cout << "Non-manifold edges: " << topo->nonManifoldEdges << std::endl;
+        std::cout << "Inconsistently wound edges: " << topo->flippedEdges << std::endl;
+        std::cout << "Degenerate facets: " << topo->degenerateFacets << std::endl;
+        std::cout << "Duplicate facets: " << topo->duplicateFacets << std::endl;
+        std::cout << (isWatertight(topo) ? "Mesh is watertight" : "Mesh is not watertight") << std::endl;
+    }
+
+}
+
+#endif // __JJC_STL_TOPOLOGY_HPP__
@@ -0,0 +1,112 @@
+/*
+    STL-Transform, placement and scaling of STL-Parser models
+    Copyright (C) 2026  STL-Parser contributors
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Author(s):
+        STL-Parser contributors
+
+    File Type: header/implementation, STL-Transform
+
+    Date Created: 10/18/2026
+
+    Date Last Modified: 10/18/2026
+
+    Purpose:
+        Applies an objParse::GLmatrix4 (scale/rotate/translate/mirror) to every facet of an stl::Model
+        Normals go through the inverse transpose so they stay perpendicular under non-uniform scaling,
+        mirroring matrices also swap two corners of each facet so the winding matches the normal again
+        objParse models use objParse::transformModel from objectParser.hpp
+
+*/
+
+#ifndef __JJC_STL_TRANSFORM_HPP__
+#define __JJC_STL_TRANSFORM_HPP__
+
+#include <STL-Parser.hpp>
+
+#include <math.h>
+
+namespace stl {
+
+    using objParse::GLmatrix4;
+    using objParse::identityMatrix;
+    using objParse::scaleMatrix;
+    using objParse::translateMatrix;
+    using objParse::rotateMatrix;
+    using objParse::multMatrix;
+
+    /* matrix for transforming normals: inverse transpose of the upper 3x3, translation is left at zero */
+    GLmatrix4 normalMatrix(const GLmatrix4& mat) {
+        const GLfloat* m = mat.m;
+        GLmatrix4 nrm = identityMatrix();
+
+        GLfloat det = objParse::matrixDeterminant3(mat);
+        if(det == 0.0f)
+            return nrm; // flattened model, normals cant be fixed so leave them alone
+
+        GLfloat inv = 1.0f / det;
+
+        // cofactors of the 3x3 divided by the determinant, which is the inverse transpose
+        nrm.m[0] = (m[5] * m[10] - m[6] * m[9]) * inv;
+        nrm.m[1] = (m[6] * m[8] - m[4] * m[10]) * inv;
+        nrm.m[2] = (m[4] * m[9] - m[5] * m[8]) * inv;
+        nrm.m[4] = (m[2] * m[9] - m[1] * m[10]) * inv;
+        nrm.m[5] = (m[0] * m[10] - m[2] * m[8]) * inv;
+        nrm.m[6] = (m[1] * m[8] - m[0] * m[9]) * inv;
+        nrm.m[8] = (m[1] * m[6] - m[2] * m[5]) * inv;
+        nrm.m[9] = (m[2] * m[4] - m[0] * m[6]) * inv;
+        nrm.m[10] = (m[0] * m[5] - m[1] * m[4]) * inv;
+
+        return nrm;
+    }
+
+    /* applies mat to the corners and normal of every facet in one pass,
+        big models are split over numThreads threads (less than 1 uses every core) */
+    void transformModel(Model* myModel, const GLmatrix4& mat, int numThreads = 0) {
+        GLmatrix4 nrm = normalMatrix(mat);
+        bool flip = objParse::matrixDeterminant3(mat) < 0.0f;
+
+        parallelFor(0, myModel->size(), numThreads, [&](size_t first, size_t last) {
+            for(size_t i = first; i < last; i++) {
+                triFloat3* tf3 = myModel->at(i);
+
+                for(int j = 0; j < 3; j++)
+                    objParse::transformPoint(mat, &tf3->pts[j]);
+
+                objParse::transformPoint(nrm, &tf3->normal);
+                GLfloat len = sqrtf(tf3->normal.x_ * tf3->normal.x_ + tf3->normal.y_ * tf3->normal.y_ + tf3->normal.z_ * tf3->normal.z_);
+                if(len > 0.0f) {
+                    tf3->normal.x_ /= len;
+                    tf3->normal.y_ /= len;
+                    tf3->normal.z_ /= len;
+                }
+
+                // mirrored facets would be wound clockwise around their normal
+                if(flip) {
+                    objParse::GLfloat3 temp = tf3->pts[1];
+                    tf3->pts[1] = tf3->pts[2];
+                    tf3->pts[2] = temp;
+                }
+            }
+        });
+    }
+
+    /* uniform scale (negative to mirror) about the origin, the runtime version of objectParser's _SCALE_ */
+    void scaleModel(Model* myModel, GLfloat scale, int numThreads = 0) {
+        transformModel(myModel, scaleMatrix(scale, scale, scale), numThreads);
+    }
+
+}
+
+#endif // __JJC_STL_TRANSFORM_HPP__
@@ -0,0 +1,276 @@
+/*
+    STL-VertexCache, post-transform cache friendly triangle ordering for STL-Parser meshes
+    Copyright (C) 2026  STL-Parser contributors
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Author(s):
+        STL-Parser contributors
+
+    File Type: header/implementation, STL-VertexCache
+
+    Date Created: 10/18/2026
+
+    Date Last Modified: 10/18/2026
+
+    Purpose:
+        Reorders the triangles of an stl::IndexedMesh (from stl::indexModel) so the GPU
+        reuses more transformed vertices, then renumbers vertices in the order they are first used
+        Triangle order uses Tom Forsyth's "Linear-Speed Vertex Cache Optimisation"
+
+*/
+
+#ifndef __JJC_STL_VERTEX_CACHE_HPP__
+#define __JJC_STL_VERTEX_CACHE_HPP__
+
+#include <STL-Parser.hpp>
+
+#include <vector>
+#include <algorithm>
+#include <math.h>
+
+namespace stl {
+
+    const int VCACHE_SIM_SIZE = 32;  // size of the LRU cache the optimizer models
+    const int VCACHE_FIFO_SIZE = 16; // size of the FIFO cache used to measure ACMR
+
+    struct VertexCacheStats {
+        GLfloat acmrBefore; // average cache misses per triangle, 0.5 is ideal for big regular meshes, 3.0 is worst
+        GLfloat acmrAfter;
+    };
+
+    /* simulates a FIFO post-transform cache and returns the average cache miss ratio */
+    GLfloat getACMR(IndexedMesh* myMesh, int cacheSize = VCACHE_FIFO_SIZE) {
+        unsigned int numTris = myMesh->indices.size() / 3;
+        if(numTris == 0)
+            return 0.0f;
+
+        // insertedAt is the miss that brought a vertex in (numbered from 1), the cache holds the last cacheSize of them
+        std::vector<unsigned int> insertedAt(myMesh->verts.size(), 0);
+        unsigned int misses = 0;
+
+        for(unsigned int i = 0; i < myMesh->indices.size(); i++) {
+            unsigned int v = myMesh->indices[i];
+            if(insertedAt[v] == 0 || misses - insertedAt[v] >= (unsigned int)cacheSize) {
+                misses++;
+                insertedAt[v] = misses;
+            }
+        }
+
+        return (GLfloat)misses / (GLfloat)numTris;
+    }
+
+//-------------------------------------------------------------
+// Forsyth scoring
+
+    GLfloat forsythVertexScore(int cachePos, int remaining) {
+        if(remaining == 0)
+            return -1.0f; // no triangles left that need this vertex
+
+        GLfloat score = 0.0f;
+        if(cachePos >= 0) {
+            if(cachePos < 3) {
+                score = 0.75f; // the last triangle used these, favoring them would make strips instead of fans
+            } else {
+                score = 1.0f - (GLfloat)(cachePos - 3) / (GLfloat)(VCACHE_SIM_SIZE - 3);
+                score = powf(score, 1.5f);
+            }
+        }
+
+        // vertices with few triangles left get a boost so they are finished off and dont linger
+        score += 2.0f / sqrtf((GLfloat)remaining);
+        return score;
+    }
+
+    /* finds a cache friendly order for the triangles of indices (which must only use vertices 0 to numVerts-1),
+        triOrder[n] is set to the triangle that should be drawn n-th */
+    void forsythReorder(const unsigned int* indices, unsigned int numTris, unsigned int numVerts, unsigned int* triOrder) {
+        if(numTris == 0)
+            return;
+
+        // triangles that use each vertex, packed into one array
+        std::vector<unsigned int> adjStart(numVerts + 1, 0);
+        for(unsigned int i = 0; i < numTris * 3; i++)
+            adjStart[indices[i] + 1]++;
+        for(unsigned int v = 0; v < numVerts; v++)
+            adjStart[v + 1] += adjStart[v];
+
+        std::vector<unsigned int> adjTris(numTris * 3);
+        std::vector<unsigned int> remaining(numVerts, 0); // also used as the fill cursor
+        for(unsigned int i = 0; i < numTris * 3; i++) {
+            unsigned int v = indices[i];
+            adjTris[adjStart[v] + remaining[v]++] = i / 3;
+        }
+
+        std::vector<int> cachePos(numVerts, -1);
+        std::vector<GLfloat> vertScore(numVerts);
+        for(unsigned int v = 0; v < numVerts; v++)
+            vertScore[v] = forsythVertexScore(-1, remaining[v]);
+
+        std::vector<GLfloat> triScore(numTris);
+        std::vector<char> emitted(numTris, 0);
+        for(unsigned int t = 0; t < numTris; t++)
+            triScore[t] = vertScore[indices[t * 3]] + vertScore[indices[t * 3 + 1]] + vertScore[indices[t * 3 + 2]];
+
+        // the extra 3 slots hold vertices pushed out by the newest triangle
+        int cache[VCACHE_SIM_SIZE + 3];
+        int cacheSize = 0;
+
+        unsigned int cursor = 0; // lowest triangle that might not be emitted yet
+        int best = -1;
+
+        for(unsigned int n = 0; n < numTris; n++) {
+            if(best < 0) {
+                // nothing in the cache touches an open triangle, start again from the next unused one
+                while(emitted[cursor])
+                    cursor++;
+                best = (int)cursor;
+            }
+
+            const unsigned int* tri = indices + best * 3;
+            emitted[best] = 1;
+            triOrder[n] = (unsigned int)best;
+
+            // remove the triangle from its vertices lists
+            for(int j = 0; j < 3; j++) {
+                unsigned int v = tri[j];
+                unsigned int* first = &adjTris[adjStart[v]];
+                unsigned int* last = first + remaining[v];
+                *std::find(first, last, (unsigned int)best) = *(last - 1);
+                remaining[v]--;
+            }
+
+            // move the triangle's vertices to the front of the LRU cache
+            int newCache[VCACHE_SIM_SIZE + 3];
+            int newSize = 0;
+            for(int j = 0; j < 3; j++)
+                newCache[newSize++] = (int)tri[j];
+            for(int i = 0; i < cacheSize; i++) {
+                int v = cache[i];
+                if(v != (int)tri[0] && v != (int)tri[1] && v != (int)tri[2])
+                    newCache[newSize++] = v;
+            }
+
+            // rescore every vertex that moved in the cache and the triangles that still use them
+            best = -1;
+            GLfloat bestScore = -1.0f;
+            for(int i = 0; i < newSize; i++) {
+                int v = newCache[i];
+                cachePos[v] = (i < VCACHE_SIM_SIZE) ? i : -1;
+                vertScore[v] = forsythVertexScore(cachePos[v], remaining[v]);
+            }
+            for(int i = 0; i < newSize; i++) {
+                int v = newCache[i];
+                for(unsigned int k = adjStart[v]; k < adjStart[v] + remaining[v]; k++) {
+                    unsigned int t = adjTris[k];
+                    triScore[t] = vertScore[indices[t * 3]] + vertScore[indices[t * 3 + 1]] + vertScore[indices[t * 3 + 2]];
+                    if(triScore[t] > bestScore) {
+                        bestScore = triScore[t];
+                        best = (int)t;
+                    }
+                }
+            }
+
+            cacheSize = std::min(newSize, VCACHE_SIM_SIZE);
+            for(int i = 0; i < cacheSize; i++)
+                cache[i] = newCache[i];
+        }
+    }
+
+    /* runs forsythReorder on triangles [first, first + numTris), vertices are renumbered
+        to 0..k-1 for the run so each thread only needs memory for the vertices it touches */
+    void forsythReorderRange(const unsigned int* indices, unsigned int first, unsigned int numTris, unsigned int* triOrder) {
+        const unsigned int* runIndices = indices + first * 3;
+        std::vector<unsigned int> used(runIndices, runIndices + numTris * 3);
+        std::sort(used.begin(), used.end());
+        used.erase(std::unique(used.begin(), used.end()), used.end());
+
+        std::vector<unsigned int> local(numTris * 3);
+        for(unsigned int i = 0; i < numTris * 3; i++)
+            local[i] = (unsigned int)(std::lower_bound(used.begin(), used.end(), runIndices[i]) - used.begin());
+
+        forsythReorder(&local[0], numTris, (unsigned int)used.size(), triOrder + first);
+
+        for(unsigned int n = 0; n < numTris; n++)
+            triOrder[first + n] += first;
+    }
+
+//-------------------------------------------------------------
+
+    /* renumbers vertices in the order the index buffer first uses them so vertex fetches walk
+        forward through memory, unreferenced vertices are dropped */
+    void optimizeVertexFetch(IndexedMesh* myMesh) {
+        const unsigned int unused = 0xFFFFFFFFu;
+        std::vector<unsigned int> remap(myMesh->verts.size(), unused);
+        std::vector<objParse::GLfloat3> newVerts;
+        newVerts.reserve(myMesh->verts.size());
+
+        for(unsigned int i = 0; i < myMesh->indices.size(); i++) {
+            unsigned int v = myMesh->indices[i];
+            if(remap[v] == unused) {
+                remap[v] = (unsigned int)newVerts.size();
+                newVerts.push_back(myMesh->verts[v]);
+            }
+            myMesh->indices[i] = remap[v];
+        }
+
+        myMesh->verts.swap(newVerts);
+    }
+
+    /* reorders triangles for the vertex cache and then vertices for fetch locality.
+        numThreads > 1 splits the triangles into that many runs and orders each one on its own thread,
+        runs only share vertices if the facets were already roughly grouped by position (chunked or BVH order),
+        otherwise the result is much worse than the single threaded one (numThreads < 1 uses every core) */
+    VertexCacheStats optimizeVertexCache(IndexedMesh* myMesh, int numThreads = 1) {
+        VertexCacheStats stats;
+        stats.acmrBefore = getACMR(myMesh);
+
+        unsigned int numTris = myMesh->indices.size() / 3;
+        std::vector<unsigned int> triOrder(numTris);
+
+        int threads = getNumThreads(numThreads);
+        if(numTris > 0) {
+            if(threads <= 1) {
+                forsythReorder(&myMesh->indices[0], numTris, (unsigned int)myMesh->verts.size(), &triOrder[0]);
+            } else {
+                parallelFor(0, numTris, threads, [&](size_t first, size_t last) {
+                    forsythReorderRange(&myMesh->indices[0], (unsigned int)first, (unsigned int)(last - first), &triOrder[0]);
+                }, 1024);
+            }
+        }
+
+        // apply the new order, per-triangle normals move with their triangles
+        std::vector<unsigned int> newIndices(numTris * 3);
+        for(unsigned int n = 0; n < numTris; n++) {
+            for(int j = 0; j < 3; j++)
+                newIndices[n * 3 + j] = myMesh->indices[triOrder[n] * 3 + j];
+        }
+        myMesh->indices.swap(newIndices);
+
+        if(myMesh->normals.size() == numTris) {
+            std::vector<objParse::GLfloat3> newNormals(numTris);
+            for(unsigned int n = 0; n < numTris; n++)
+                newNormals[n] = myMesh->normals[triOrder[n]];
+            myMesh->normals.swap(newNormals);
+        }
+
+        optimizeVertexFetch(myMesh);
+
+        stats.acmrAfter = getACMR(myMesh);
+        std::cout << "ACMR before: " << stats.acmrBefore << " after: " << stats.acmrAfter << std::endl;
+
+        return stats;
+    }
+
+}
+
+#endif // __JJC_STL_VERTEX_CACHE_HPP__
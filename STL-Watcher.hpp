@@ -0,0 +1,391 @@
+/*
+    STL-Watcher, hot reloading of .stl and objectParser files while a viewer is running
+    Copyright (C) 2026  STL-Parser contributors
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Author(s):
+        STL-Parser contributors
+
+    File Type: header/implementation, STL-Watcher
+
+    Date Created: 10/18/2026
+
+    Date Last Modified: 10/18/2026
+
+    Purpose:
+        Watches the directories of loaded files with inotify (Linux only)
+        Changed files are reparsed on a background thread, the render thread picks up the new
+        geometry in pollHotReload() so all OpenGL calls stay on the thread that owns the context
+        Binary .stl files are compared facet block by facet block against the previous version and
+        only the display lists of blocks that actually changed are recompiled
+
+    Misc. Notes:
+        Only finished writes are picked up (IN_CLOSE_WRITE and IN_MOVED_TO), editors that save by
+        renaming a temp file over the original are handled because the directory is watched, not the file
+
+*/
+
+#ifndef __JJC_STL_WATCHER_HPP__
+#define __JJC_STL_WATCHER_HPP__
+
+#include <STL-Parser.hpp>
+
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#include <limits.h>
+#include <stdlib.h> // for realpath()
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
+
+namespace stl {
+
+    const unsigned int WATCH_BLOCK_FACETS = 4096; // facets per display list for watched .stl files
+
+    struct WatchedFile {
+        std::string path;
+        std::string canonical; // realpath of path, what inotify events are matched against
+        bool xml;        // objectParser file instead of .stl
+        GLfloat scale;   // xml only, passed to parseBotModel / loadBotModel
+
+        // current geometry, only touched by the render thread
+        Model* model;              // .stl files
+        objParse::Model* quads;    // xml files
+        std::vector<GLuint> lists; // .stl: one list per WATCH_BLOCK_FACETS facets, xml: one list
+
+        // only touched by the watcher thread
+        std::vector<char> raw;     // last contents of a binary .stl, what the next version is compared to
+
+        // handed from the watcher thread to the render thread, protected by FileWatcher::lock
+        bool pending;
+        Model* pendingModel;
+        objParse::Model* pendingQuads;
+        std::vector<bool> dirtyBlocks; // empty means everything changed
+    };
+
+    struct FileWatcher {
+        int fd; // inotify instance
+        std::unordered_map<int, std::string> dirs; // watch descriptor -> canonical directory
+        std::vector<WatchedFile*> files;
+
+        std::thread worker;
+        std::mutex lock;
+        std::atomic<bool> running;
+    };
+
+    FileWatcher* newFileWatcher(void) {
+        FileWatcher* watcher = new FileWatcher;
+        watcher->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        watcher->running = false;
+
+        if(watcher->fd < 0)
+            std::cerr << "inotify not available, files will not be reloaded" << std::endl;
+
+        return watcher;
+    }
+
+    bool hasSuffix(const std::string& str, const char* suffix) {
+        size_t len = strlen(suffix);
+        if(str.size() < len)
+            return false;
+        return strcasecmp(str.c_str() + str.size() - len, suffix) == 0;
+    }
+
+    /* parses a .stl file from memory in whatever format it is in, safe to call from the watcher thread */
+    Model* parseBufferAny(std::vector<char>* buffer) {
+        const char* data = buffer->empty() ? NULL : &buffer->at(0);
+        if(isBinarySTL(data, buffer->size()))
+            return parseBufferBinary(data, buffer->size());
+
+        std::istringstream stream(std::string(buffer->begin(), buffer->end()));
+        return parseStreamAscii(stream);
+    }
+
+    /* loads a file and starts watching its directory, .xml files go through objectParser */
+    WatchedFile* watchFile(FileWatcher* watcher, char* path, GLfloat scale = _SCALE_) {
+        WatchedFile* file = new WatchedFile;
+        file->path = path;
+        file->canonical = path;
+        file->xml = hasSuffix(file->path, ".xml");
+        file->scale = scale;
+        file->model = NULL;
+        file->quads = NULL;
+        file->pending = false;
+        file->pendingModel = NULL;
+        file->pendingQuads = NULL;
+
+        if(file->xml) {
+            file->quads = objParse::parseBotModel(path, scale);
+        } else {
+            std::vector<char> buffer;
+            if(!readFileBuffer(path, &buffer)) {
+                std::cerr << "Invalid filename" << std::endl;
+                exit(1);
+            }
+            file->model = parseBufferAny(&buffer);
+            if(isBinarySTL(buffer.empty() ? NULL : &buffer[0], buffer.size()))
+                file->raw.swap(buffer);
+        }
+
+        // the same directory can be reached by many spellings ("parts/a.stl", "/abs/parts/b.stl", "./parts/../parts/c.stl")
+        // but inotify only has one watch for it, so every file is matched by its canonical path
+        char* resolved = realpath(path, NULL);
+        if(resolved != NULL) {
+            file->canonical = resolved;
+            free(resolved);
+        }
+
+        std::lock_guard<std::mutex> guard(watcher->lock);
+
+        if(watcher->fd >= 0) {
+            size_t slash = file->canonical.rfind('/');
+            std::string dir = (slash == std::string::npos) ? "." : file->canonical.substr(0, slash);
+            if(dir.empty())
+                dir = "/";
+
+            // inotify hands back the same descriptor if the directory is already watched,
+            // it was stored under the same canonical name then so overwriting it changes nothing
+            int wd = inotify_add_watch(watcher->fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+            if(wd >= 0)
+                watcher->dirs[wd] = dir;
+        }
+
+        watcher->files.push_back(file);
+        return file;
+    }
+
+    /* worker side of a reload: parse the new version and work out which blocks changed */
+    void reloadFile(FileWatcher* watcher, WatchedFile* file) {
+        Model* newModel = NULL;
+        objParse::Model* newQuads = NULL;
+        std::vector<bool> dirty;
+
+        if(file->xml) {
+            // a half saved or broken file must not take the viewer down, keep showing the old version instead
+            newQuads = objParse::loadBotModel((char*)file->path.c_str(), file->scale);
+            if(newQuads == NULL)
+                return;
+        } else {
+            std::vector<char> buffer;
+            if(!readFileBuffer((char*)file->path.c_str(), &buffer))
+                return; // deleted or unreadable, keep showing what we have
+
+            const char* data = buffer.empty() ? NULL : &buffer[0];
+            bool binary = isBinarySTL(data, buffer.size());
+
+            // same facet count means the blocks line up, compare the records block by block
+            if(binary && buffer.size() == file->raw.size()) {
+                unsigned int numFacets = getBinaryFacetCount(data, buffer.size());
+                unsigned int numBlocks = (numFacets + WATCH_BLOCK_FACETS - 1) / WATCH_BLOCK_FACETS;
+                dirty.resize(numBlocks, false);
+
+                bool changed = false;
+                for(unsigned int b = 0; b < numBlocks; b++) {
+                    size_t first = 84 + (size_t)b * WATCH_BLOCK_FACETS * 50;
+                    size_t count = std::min(WATCH_BLOCK_FACETS, numFacets - b * WATCH_BLOCK_FACETS) * 50;
+                    dirty[b] = memcmp(&buffer[first], &file->raw[first], count) != 0;
+                    changed = changed || dirty[b];
+                }
+
+                if(!changed)
+                    return; // saved without changing any facets
+            }
+
+            newModel = parseBufferAny(&buffer);
+
+            if(binary)
+                file->raw.swap(buffer);
+            else
+                file->raw.clear();
+        }
+
+        std::lock_guard<std::mutex> guard(watcher->lock);
+
+        // the render thread hasnt picked up the last version yet, replace it and merge the dirty blocks
+        if(file->pending) {
+            if(file->pendingModel != NULL)
+                freeModel(file->pendingModel);
+            if(file->pendingQuads != NULL)
+                objParse::freeBotModel(file->pendingQuads);
+
+            if(file->dirtyBlocks.empty() || dirty.size() != file->dirtyBlocks.size()) {
+                dirty.clear();
+            } else {
+                for(unsigned int b = 0; b < dirty.size(); b++)
+                    dirty[b] = dirty[b] || file->dirtyBlocks[b];
+            }
+        }
+
+        file->pending = true;
+        file->pendingModel = newModel;
+        file->pendingQuads = newQuads;
+        file->dirtyBlocks.swap(dirty);
+
+        std::cout << "Reloaded " << file->path << std::endl;
+    }
+
+    void watcherLoop(FileWatcher* watcher) {
+        // big enough for at least one event with the longest possible name
+        char events[sizeof(struct inotify_event) + NAME_MAX + 1] __attribute__((aligned(__alignof__(struct inotify_event))));
+
+        while(watcher->running) {
+            struct pollfd pfd;
+            pfd.fd = watcher->fd;
+            pfd.events = POLLIN;
+
+            // wake up now and then to check if we have been stopped
+            if(poll(&pfd, 1, 100) <= 0)
+                continue;
+
+            ssize_t length = read(watcher->fd, events, sizeof(events));
+            for(ssize_t offset = 0; offset < length; ) {
+                struct inotify_event* event = (struct inotify_event*)(events + offset);
+                offset += sizeof(struct inotify_event) + event->len;
+
+                if(event->len == 0)
+                    continue;
+
+                // find the file by its canonical path, it may have been watched more than once
+                std::vector<WatchedFile*> changed;
+                {
+                    std::lock_guard<std::mutex> guard(watcher->lock);
+                    std::string dir = watcher->dirs[event->wd];
+                    std::string path = dir + ((dir == "/") ? "" : "/") + event->name;
+                    for(unsigned int i = 0; i < watcher->files.size(); i++) {
+                        if(watcher->files[i]->canonical == path)
+                            changed.push_back(watcher->files[i]);
+                    }
+                }
+
+                for(unsigned int i = 0; i < changed.size(); i++)
+                    reloadFile(watcher, changed[i]);
+            }
+        }
+    }
+
+    /* starts reparsing changed files in the background */
+    void startWatcher(FileWatcher* watcher) {
+        if(watcher->fd < 0 || watcher->running)
+            return;
+
+        watcher->running = true;
+        watcher->worker = std::thread(watcherLoop, watcher);
+    }
+
+    void stopWatcher(FileWatcher* watcher) {
+        if(!watcher->running)
+            return;
+
+        watcher->running = false;
+        watcher->worker.join();
+    }
+
+//-------------------------------------------------------------
+// render thread side
+
+    /* compiles one block of a watched .stl model into list, same look as getBot */
+    void compileWatchedBlock(Model* myModel, unsigned int block, GLuint list) {
+        unsigned int first = block * WATCH_BLOCK_FACETS;
+        unsigned int last = std::min((unsigned int)myModel->size(), first + WATCH_BLOCK_FACETS);
+
+        glNewList(list, GL_COMPILE);
+        glBegin(GL_TRIANGLES);
+
+            for(unsigned int i = first; i < last; i++) {
+                // all triangles will be green
+                glColor3f(0.0f, 1.0f, 0.0f);
+
+                for(int j = 0; j < 3; j++) {
+                    glVertex3f(myModel->at(i)->pts[j].x_, myModel->at(i)->pts[j].y_, myModel->at(i)->pts[j].z_);
+                }
+            }
+
+        glEnd();
+        glEndList();
+    }
+
+    /* (re)builds the display lists of a file, dirty == NULL rebuilds everything */
+    void compileWatchedFile(WatchedFile* file, std::vector<bool>* dirty) {
+        if(file->xml) {
+            for(unsigned int i = 0; i < file->lists.size(); i++)
+                glDeleteLists(file->lists[i], 1);
+            file->lists.clear();
+            file->lists.push_back(objParse::getBot(file->quads));
+            return;
+        }
+
+        unsigned int numBlocks = (file->model->size() + WATCH_BLOCK_FACETS - 1) / WATCH_BLOCK_FACETS;
+        bool all = (dirty == NULL || dirty->size() != numBlocks || file->lists.size() != numBlocks);
+
+        if(file->lists.size() != numBlocks) {
+            for(unsigned int i = 0; i < file->lists.size(); i++)
+                glDeleteLists(file->lists[i], 1);
+            file->lists.clear();
+            for(unsigned int b = 0; b < numBlocks; b++)
+                file->lists.push_back(glGenLists(1));
+        }
+
+        for(unsigned int b = 0; b < numBlocks; b++) {
+            if(all || dirty->at(b))
+                compileWatchedBlock(file->model, b, file->lists[b]); // recompiling reuses the same list name
+        }
+    }
+
+    /* call once per frame from the render thread, swaps in any geometry the watcher has reloaded.
+        Model pointers from before the call are freed if their file changed. returns how many files were swapped */
+    int pollHotReload(FileWatcher* watcher) {
+        int swapped = 0;
+
+        std::lock_guard<std::mutex> guard(watcher->lock);
+        for(unsigned int i = 0; i < watcher->files.size(); i++) {
+            WatchedFile* file = watcher->files[i];
+            if(!file->pending)
+                continue;
+
+            if(file->xml) {
+                objParse::freeBotModel(file->quads);
+                file->quads = file->pendingQuads;
+            } else {
+                freeModel(file->model);
+                file->model = file->pendingModel;
+            }
+
+            compileWatchedFile(file, file->dirtyBlocks.empty() ? NULL : &file->dirtyBlocks);
+
+            file->pending = false;
+            file->pendingModel = NULL;
+            file->pendingQuads = NULL;
+            file->dirtyBlocks.clear();
+            swapped++;
+        }
+
+        return swapped;
+    }
+
+    /* draws the current version of a watched file, lists are built the first time */
+    void drawWatched(WatchedFile* file) {
+        if(file->lists.empty())
+            compileWatchedFile(file, NULL);
+
+        for(unsigned int i = 0; i < file->lists.size(); i++)
+            glCallList(file->lists[i]);
+    }
+
+}
+
+#endif // __JJC_STL_WATCHER_HPP__
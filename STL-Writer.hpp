@@ -0,0 +1,226 @@
+/*
+    STL-Writer, saves STL-Parser models as binary or ascii .stl files
+    Copyright (C) 2026  STL-Parser contributors
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Author(s):
+        STL-Parser contributors
+
+    File Type: header/implementation, STL-Writer
+
+    Date Created: 10/18/2026
+
+    Date Last Modified: 10/18/2026
+
+    Purpose:
+        Writes a Model or ContiguousModel (packMultiModelContiguous) back out, for converting ascii exports
+        to binary and saving merged or transformed meshes
+        Binary records are filled straight into a large buffer, ascii text is formatted a block of facets
+        per thread and written in order, neither makes a stream call per facet
+
+    Misc. Notes:
+        Floats in ascii files are printed with the fewest digits that read back to the exact same float
+        (std::to_chars when the standard library has it, otherwise the shortest %g that round trips)
+
+*/
+
+#ifndef __JJC_STL_WRITER_HPP__
+#define __JJC_STL_WRITER_HPP__
+
+#include <STL-Parser.hpp>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#if __cplusplus >= 201703L && defined(__has_include)
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+#endif
+
+namespace stl {
+
+    const unsigned int WRITER_BLOCK_FACETS = 16384; // facets per buffered write (and per ascii formatting job)
+
+    inline const triFloat3* getFacet(Model* myModel, size_t i) {
+        return myModel->at(i);
+    }
+
+    inline const triFloat3* getFacet(ContiguousModel* myModel, size_t i) {
+        return &(*myModel)[i];
+    }
+
+    /* writes the shortest text that strtof turns back into exactly value, returns the number of chars (no terminator) */
+    int formatFloat(GLfloat value, char* out) {
+#ifdef __cpp_lib_to_chars
+        std::to_chars_result result = std::to_chars(out, out + 31, value);
+        return (int)(result.ptr - out);
+#else
+        // most floats need 7 or 8 significant digits so start at 7, 9 digits always round trip
+        int length = snprintf(out, 32, "%.7g", value);
+        if(strtof(out, NULL) == value) {
+            char shorter[32];
+            int shortLength = snprintf(shorter, 32, "%.6g", value);
+            if(strtof(shorter, NULL) == value) {
+                memcpy(out, shorter, shortLength + 1);
+                return shortLength;
+            }
+            return length;
+        }
+
+        length = snprintf(out, 32, "%.8g", value);
+        if(strtof(out, NULL) == value)
+            return length;
+        return snprintf(out, 32, "%.9g", value);
+#endif // __cpp_lib_to_chars
+    }
+
+    void appendFloat3(std::string* text, const objParse::GLfloat3& v) {
+        char number[32];
+        text->push_back(' ');
+        text->append(number, formatFloat(v.x_, number));
+        text->push_back(' ');
+        text->append(number, formatFloat(v.y_, number));
+        text->push_back(' ');
+        text->append(number, formatFloat(v.z_, number));
+        text->push_back('\n');
+    }
+
+    /* binary .stl: 80 byte header, facet count, then 50 bytes per facet */
+    template<typename ModelType>
+    bool writeBinaryFacets(ModelType* myModel, const char* filename, const char* header) {
+        FILE* ofile = fopen(filename, "wb");
+        if(ofile == NULL) {
+            std::cerr << "Cannot open " << filename << " for writing" << std::endl;
+            return false;
+        }
+
+        // anything starting with 'solid' looks like an ascii file to some readers
+        char start[84];
+        memset(start, 0, sizeof(start));
+        strncpy(start, (header != NULL) ? header : "binary STL written by STL-Parser", 80);
+
+        unsigned int numFacets = myModel->size();
+        writeLittleEndian32(start + 80, numFacets);
+
+        bool ok = fwrite(start, 1, 84, ofile) == 84;
+
+        std::vector<char> buffer(50 * WRITER_BLOCK_FACETS, 0); // attribute bytes are never written to, they stay zero
+        for(size_t first = 0; ok && first < numFacets; first += WRITER_BLOCK_FACETS) {
+            size_t count = std::min((size_t)WRITER_BLOCK_FACETS, numFacets - first);
+
+            char* record = &buffer[0];
+            for(size_t i = first; i < first + count; i++) {
+                const triFloat3* tf3 = getFacet(myModel, i);
+                memcpy(record, &tf3->normal, 12);
+                memcpy(record + 12, tf3->pts, 36);
+                convertLittleEndian32(record, record, 12);
+                record += 50;
+            }
+
+            ok = fwrite(&buffer[0], 50, count, ofile) == count;
+        }
+
+        if(fclose(ofile) != 0)
+            ok = false;
+
+        if(!ok)
+            std::cerr << "Error writing " << filename << std::endl;
+        return ok;
+    }
+
+    /* ascii .stl, each thread formats its own blocks and they are written in order once the whole batch is done */
+    template<typename ModelType>
+    bool writeAsciiFacets(ModelType* myModel, const char* filename, const char* name, int numThreads) {
+        FILE* ofile = fopen(filename, "wb");
+        if(ofile == NULL) {
+            std::cerr << "Cannot open " << filename << " for writing" << std::endl;
+            return false;
+        }
+
+        std::string solid = std::string("solid ") + name + "\n";
+        bool ok = fwrite(solid.data(), 1, solid.size(), ofile) == solid.size();
+
+        size_t numFacets = myModel->size();
+        size_t numBlocks = (numFacets + WRITER_BLOCK_FACETS - 1) / WRITER_BLOCK_FACETS;
+        size_t batchBlocks = (size_t)getNumThreads(numThreads) * 2; // bounds memory to a couple of blocks per thread
+
+        std::vector<std::string> blocks(batchBlocks);
+
+        for(size_t batch = 0; ok && batch < numBlocks; batch += batchBlocks) {
+            size_t count = std::min(batchBlocks, numBlocks - batch);
+
+            parallelFor(0, count, numThreads, [&](size_t firstBlock, size_t lastBlock) {
+                for(size_t b = firstBlock; b < lastBlock; b++) {
+                    std::string* text = &blocks[b];
+                    size_t first = (batch + b) * WRITER_BLOCK_FACETS;
+                    size_t last = std::min(first + WRITER_BLOCK_FACETS, numFacets);
+
+                    text->clear();
+                    text->reserve((last - first) * 256);
+
+                    for(size_t i = first; i < last; i++) {
+                        const triFloat3* tf3 = getFacet(myModel, i);
+                        text->append("facet normal");
+                        appendFloat3(text, tf3->normal);
+                        text->append("  outer loop\n");
+                        for(int j = 0; j < 3; j++) {
+                            text->append("    vertex");
+                            appendFloat3(text, tf3->pts[j]);
+                        }
+                        text->append("  endloop\nendfacet\n");
+                    }
+                }
+            }, 1);
+
+            for(size_t b = 0; ok && b < count; b++)
+                ok = fwrite(blocks[b].data(), 1, blocks[b].size(), ofile) == blocks[b].size();
+        }
+
+        std::string endsolid = std::string("endsolid ") + name + "\n";
+        if(ok)
+            ok = fwrite(endsolid.data(), 1, endsolid.size(), ofile) == endsolid.size();
+
+        if(fclose(ofile) != 0)
+            ok = false;
+
+        if(!ok)
+            std::cerr << "Error writing " << filename << std::endl;
+        return ok;
+    }
+
+    /* header is copied into the 80 byte header (NULL for a default one), returns false if the file couldnt be written */
+    bool writeFileBinary(Model* myModel, const char* filename, const char* header = NULL) {
+        return writeBinaryFacets(myModel, filename, header);
+    }
+
+    bool writeFileBinary(ContiguousModel* myModel, const char* filename, const char* header = NULL) {
+        return writeBinaryFacets(myModel, filename, header);
+    }
+
+    /* name goes after 'solid' on the first line, numThreads less than 1 uses every core */
+    bool writeFileAscii(Model* myModel, const char* filename, const char* name = "STL-Parser", int numThreads = 0) {
+        return writeAsciiFacets(myModel, filename, name, numThreads);
+    }
+
+    bool writeFileAscii(ContiguousModel* myModel, const char* filename, const char* name = "STL-Parser", int numThreads = 0) {
+        return writeAsciiFacets(myModel, filename, name, numThreads);
+    }
+
+}
+
+#endif // __JJC_STL_WRITER_HPP__
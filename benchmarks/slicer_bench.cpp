@@ -0,0 +1,111 @@
+/*
+    slicer_bench, thread scaling of stl::sliceModel
+    Copyright (C) 2026  STL-Parser contributors
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Author(s):
+        STL-Parser contributors
+
+    File Type: benchmark, STL-Slicer
+
+    Date Created: 10/18/2026
+
+    Date Last Modified: 10/18/2026
+
+    Purpose:
+        Slices a generated 1M triangle part (a 50 mm hollow sphere, outer and inner shell) at 0.05 mm layers
+        with 1 to N threads and prints layers per second, so the scaling of sliceModel can be measured
+
+    Build (from the repository root, rapidxml headers on the include path for objectParser.hpp):
+        g++ -O2 -std=c++11 -pthread -I. -I/path/to/rapidxml benchmarks/slicer_bench.cpp -o slicer_bench -lGL
+
+    Usage:
+        ./slicer_bench [maxThreads] [layerHeight]
+        maxThreads defaults to every core, layerHeight to 0.05
+
+*/
+
+#include <STL-Slicer.hpp>
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace stl;
+
+// adds a UV sphere of 2 * rings * segments triangles, flip turns it inside out (for the inner shell)
+void addSphere(Model* myModel, GLfloat radius, int rings, int segments, bool flip) {
+    for(int i = 0; i < rings; i++) {
+        for(int j = 0; j < segments; j++) {
+            objParse::GLfloat3 corner[4];
+            for(int k = 0; k < 4; k++) {
+                int ring = i + ((k == 1 || k == 2) ? 1 : 0);
+                int seg = (j + ((k >= 2) ? 1 : 0)) % segments;
+                GLfloat theta = (GLfloat)M_PI * ring / rings;
+                GLfloat phi = 2.0f * (GLfloat)M_PI * seg / segments;
+                corner[k].x_ = radius * sinf(theta) * cosf(phi);
+                corner[k].y_ = radius * sinf(theta) * sinf(phi);
+                corner[k].z_ = radius * cosf(theta);
+            }
+
+            // two triangles per quad, wound counter-clockwise seen from outside
+            for(int t = 0; t < 2; t++) {
+                triFloat3* tf3 = new triFloat3;
+                tf3->pts[0] = corner[0];
+                tf3->pts[1] = corner[flip ? 2 + t : 1 + t];
+                tf3->pts[2] = corner[flip ? 1 + t : 2 + t];
+                tf3->normal.x_ = tf3->normal.y_ = tf3->normal.z_ = 0.0f;
+                tf3->r_ = tf3->g_ = tf3->b_ = 0.0f;
+                myModel->push_back(tf3);
+            }
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    int maxThreads = (argc > 1) ? atoi(argv[1]) : getNumThreads(0);
+    GLfloat layerHeight = (argc > 2) ? (GLfloat)atof(argv[2]) : 0.05f;
+
+    Model* part = new Model;
+    addSphere(part, 25.0f, 500, 1000, false); // 1,000,000 triangles
+    addSphere(part, 20.0f, 50, 100, true);    //    10,000 triangles
+    printf("part: %u triangles, layer height %g mm\n", (unsigned int)part->size(), layerHeight);
+
+    double baseTime = 0.0;
+    for(int threads = 1; threads <= maxThreads; threads++) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::vector<SliceLayer>* layers = sliceModel(part, layerHeight, threads);
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+        double seconds = std::chrono::duration<double>(end - start).count();
+        if(threads == 1)
+            baseTime = seconds;
+
+        size_t loops = 0;
+        size_t open = 0;
+        for(unsigned int k = 0; k < layers->size(); k++) {
+            for(unsigned int l = 0; l < layers->at(k).loops.size(); l++) {
+                loops++;
+                open += layers->at(k).loops[l].closed ? 0 : 1;
+            }
+        }
+
+        printf("threads %2d: %6u layers in %8.1f ms, %9.0f layers/s, speedup %.2fx, %u loops (%u open)\n",
+                threads, (unsigned int)layers->size(), seconds * 1000.0, layers->size() / seconds,
+                baseTime / seconds, (unsigned int)loops, (unsigned int)open);
+        delete layers;
+    }
+
+    freeModel(part);
+    return 0;
+}
@@ -20,7 +20,7 @@
 
     Date Created: 6/8/2016
 
-    Date Last Modified: 8/5/2016
+    Date Last Modified: 10/18/2026
 
     Purpose:
         Parse model files written in custom xml-based object description language
@@ -51,10 +51,20 @@
 // for strcmp function
 #include <string.h>
 
+// worker threads for the heavier mesh passes, needs -std=c++11 -pthread
+#include <thread>
+
+#include <algorithm>
+#include <math.h>
+
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif // __SSE__
+
 // should use a typedef instead
 #define ObjModel vector<Quadfloat3*>*
 
-// allow user to optionally define a different scaling factor
+// allow user to optionally define a different default scaling factor, parseBotFile also takes one at runtime
 #ifndef _SCALE_
     #define _SCALE_ (GLfloat)1.0
 #endif // _SCALE_
@@ -103,11 +113,219 @@ namespace objParse {
 
     Model* GLfloatVec = NULL;
 
-    /* parses xml file containing physical description of robot */
-    void parseBotFile(char* filename) { // expects Model to be empty
+    /* number of worker threads to use when the caller asks for numThreads,
+        anything less than 1 means use every core the system reports */
+    int getNumThreads(int numThreads) {
+        if(numThreads > 0)
+            return numThreads;
+
+        int cores = (int)std::thread::hardware_concurrency();
+        return (cores > 0) ? cores : 1;
+    }
+
+    /* splits [begin, end) into one contiguous range per thread and calls func(rangeBegin, rangeEnd) on each,
+        small ranges are run on the calling thread so there is no point checking the size before calling */
+    template<typename Func>
+    void parallelFor(size_t begin, size_t end, int numThreads, Func func, size_t minPerThread = 4096) {
+        size_t total = (end > begin) ? end - begin : 0;
+        size_t threads = (size_t)getNumThreads(numThreads);
+
+        if(threads > total / minPerThread)
+            threads = total / minPerThread;
+
+        if(threads <= 1) {
+            func(begin, end);
+            return;
+        }
+
+        std::vector<std::thread> workers;
+        size_t step = total / threads;
+
+        for(size_t i = 0; i < threads - 1; i++)
+            workers.push_back(std::thread(func, begin + i * step, begin + (i + 1) * step));
+
+        func(begin + (threads - 1) * step, end); // calling thread takes the last range
+
+        for(size_t i = 0; i < workers.size(); i++)
+            workers[i].join();
+    }
+
+    /* std::sort on numThreads threads: every thread sorts its own range, then neighbouring ranges are merged in pairs */
+    template<typename T>
+    void parallelSort(std::vector<T>* data, int numThreads, size_t minPerThread = 65536) {
+        size_t total = data->size();
+        size_t threads = (size_t)getNumThreads(numThreads);
+
+        if(threads > total / minPerThread)
+            threads = total / minPerThread;
+
+        if(threads <= 1) {
+            std::sort(data->begin(), data->end());
+            return;
+        }
+
+        std::vector<size_t> bounds(threads + 1);
+        for(size_t i = 0; i <= threads; i++)
+            bounds[i] = total * i / threads;
+
+        typename std::vector<T>::iterator first = data->begin();
+        std::vector<std::thread> workers;
+
+        for(size_t i = 0; i < threads; i++)
+            workers.push_back(std::thread([=]() { std::sort(first + bounds[i], first + bounds[i + 1]); }));
+        for(size_t i = 0; i < workers.size(); i++)
+            workers[i].join();
+
+        for(size_t width = 1; width < threads; width *= 2) {
+            workers.clear();
+            for(size_t i = 0; i + width < threads; i += 2 * width) {
+                size_t last = std::min(i + 2 * width, threads);
+                workers.push_back(std::thread([=]() {
+                    std::inplace_merge(first + bounds[i], first + bounds[i + width], first + bounds[last]);
+                }));
+            }
+            for(size_t i = 0; i < workers.size(); i++)
+                workers[i].join();
+        }
+    }
+
+//-------------------------------------------------------------
+// transforms
+
+    // 4x4 matrix stored column major like OpenGL, so it can also be given to glMultMatrixf
+    struct GLmatrix4 {
+        GLfloat m[16];
+    };
+
+    GLmatrix4 identityMatrix(void) {
+        GLmatrix4 mat;
+        for(int i = 0; i < 16; i++)
+            mat.m[i] = (i % 5 == 0) ? 1.0f : 0.0f;
+        return mat;
+    }
+
+    /* negative values mirror along that axis */
+    GLmatrix4 scaleMatrix(GLfloat x, GLfloat y, GLfloat z) {
+        GLmatrix4 mat = identityMatrix();
+        mat.m[0] = x;
+        mat.m[5] = y;
+        mat.m[10] = z;
+        return mat;
+    }
+
+    GLmatrix4 translateMatrix(GLfloat x, GLfloat y, GLfloat z) {
+        GLmatrix4 mat = identityMatrix();
+        mat.m[12] = x;
+        mat.m[13] = y;
+        mat.m[14] = z;
+        return mat;
+    }
+
+    /* rotation of angle degrees around the axis (x, y, z), same as glRotatef */
+    GLmatrix4 rotateMatrix(GLfloat angle, GLfloat x, GLfloat y, GLfloat z) {
+        GLmatrix4 mat = identityMatrix();
+
+        GLfloat len = sqrtf(x * x + y * y + z * z);
+        if(len == 0.0f)
+            return mat;
+        x /= len;
+        y /= len;
+        z /= len;
+
+        GLfloat rad = angle * 3.14159265f / 180.0f;
+        GLfloat c = cosf(rad);
+        GLfloat s = sinf(rad);
+        GLfloat t = 1.0f - c;
+
+        mat.m[0] = x * x * t + c;     mat.m[4] = x * y * t - z * s; mat.m[8] = x * z * t + y * s;
+        mat.m[1] = y * x * t + z * s; mat.m[5] = y * y * t + c;     mat.m[9] = y * z * t - x * s;
+        mat.m[2] = z * x * t - y * s; mat.m[6] = z * y * t + x * s; mat.m[10] = z * z * t + c;
+
+        return mat;
+    }
+
+    /* returns a * b, so b is applied to points first */
+    GLmatrix4 multMatrix(const GLmatrix4& a, const GLmatrix4& b) {
+        GLmatrix4 mat;
+        for(int col = 0; col < 4; col++) {
+            for(int row = 0; row < 4; row++) {
+                GLfloat sum = 0.0f;
+                for(int k = 0; k < 4; k++)
+                    sum += a.m[k * 4 + row] * b.m[col * 4 + k];
+                mat.m[col * 4 + row] = sum;
+            }
+        }
+        return mat;
+    }
+
+    /* determinant of the upper 3x3, negative when the matrix mirrors the model */
+    GLfloat matrixDeterminant3(const GLmatrix4& mat) {
+        const GLfloat* m = mat.m;
+        return m[0] * (m[5] * m[10] - m[9] * m[6])
+             - m[4] * (m[1] * m[10] - m[9] * m[2])
+             + m[8] * (m[1] * m[6] - m[5] * m[2]);
+    }
+
+    /* affine transform of a single point, the inner loop of every transformModel */
+    inline void transformPoint(const GLmatrix4& mat, GLfloat3* pt) {
+#ifdef __SSE__
+        __m128 r = _mm_mul_ps(_mm_loadu_ps(mat.m), _mm_set1_ps(pt->x_));
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(mat.m + 4), _mm_set1_ps(pt->y_)));
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(mat.m + 8), _mm_set1_ps(pt->z_)));
+        r = _mm_add_ps(r, _mm_loadu_ps(mat.m + 12));
+
+        GLfloat out[4];
+        _mm_storeu_ps(out, r);
+        pt->x_ = out[0];
+        pt->y_ = out[1];
+        pt->z_ = out[2];
+#else
+        const GLfloat* m = mat.m;
+        GLfloat x = pt->x_;
+        GLfloat y = pt->y_;
+        GLfloat z = pt->z_;
+        pt->x_ = m[0] * x + m[4] * y + m[8] * z + m[12];
+        pt->y_ = m[1] * x + m[5] * y + m[9] * z + m[13];
+        pt->z_ = m[2] * x + m[6] * y + m[10] * z + m[14];
+#endif // __SSE__
+    }
+
+    /* applies mat to every quad in one pass, split over numThreads threads for big models.
+        when mat mirrors the model the corner order is reversed so quads keep facing outward,
+        pass fixWinding = false to keep the original corner order */
+    void transformModel(Model* GLfloatVec, const GLmatrix4& mat, int numThreads = 0, bool fixWinding = true) {
+        bool flip = fixWinding && matrixDeterminant3(mat) < 0.0f;
+
+        parallelFor(0, GLfloatVec->size(), numThreads, [&](size_t first, size_t last) {
+            for(size_t i = first; i < last; i++) {
+                Quadfloat3* myquad = GLfloatVec->at(i);
+                for(int j = 0; j < 4; j++)
+                    transformPoint(mat, &myquad->pts[j]);
+
+                if(flip) {
+                    GLfloat3 temp = myquad->pts[1];
+                    myquad->pts[1] = myquad->pts[3];
+                    myquad->pts[3] = temp;
+                }
+            }
+        });
+    }
+
+    /* frees a half built Model, always returns NULL so errors can just return freeBotModel(GLfloatVec) */
+    Model* freeBotModel(Model* GLfloatVec) {
+        for(unsigned int i = 0; i < GLfloatVec->size(); i++)
+            delete GLfloatVec->at(i);
+        delete GLfloatVec;
+        return NULL;
+    }
+
+    /* parses xml file containing physical description of robot into a new Model, every coordinate and shift is divided by scale.
+        returns NULL (after printing why) if the file cant be read or isnt a valid description, nothing exits
+        (the global GLfloatVec is not touched so this is safe to call from another thread) */
+    Model* loadBotModel(char* filename, GLfloat scale = _SCALE_) {
 
         //GLfloatVec = new vector<Quadfloat3*>;
-        GLfloatVec = new Model;
+        Model* GLfloatVec = new Model; // hides the global on purpose
         GLfloatVec->clear();
 
         // parse file containing description of robot
@@ -116,15 +334,24 @@ namespace objParse {
 
         cout << "Creating xml file object" << endl;
         ifstream myfile(filename);
+        if(!myfile.is_open()) {
+            cerr << "Cannot open " << filename << endl;
+            return freeBotModel(GLfloatVec);
+        }
         vector<char> fileBuffer((istreambuf_iterator<char>(myfile)), istreambuf_iterator<char>( ));
         fileBuffer.push_back('\0');
 
-        doc.parse<rapidxml::parse_trim_whitespace>(&fileBuffer[0]); // parse the contents of the file
+        try {
+            doc.parse<rapidxml::parse_trim_whitespace>(&fileBuffer[0]); // parse the contents of the file
+        } catch(rapidxml::parse_error& e) {
+            cerr << "XML error in " << filename << ": " << e.what() << endl;
+            return freeBotModel(GLfloatVec);
+        }
         rapidxml::xml_node<>* root = doc.first_node("body"); // find our root node
 
         if(root == NULL) {
             cerr << "No 'body' tag found" << endl;
-            exit(1);
+            return freeBotModel(GLfloatVec);
         }
 
         rapidxml::xml_attribute<>* attr = root->first_attribute("name");
@@ -132,13 +359,13 @@ namespace objParse {
             cout << "object name: " << attr->value() << endl;
         } else {
             cerr << "Object name not given" << endl;
-            exit(1);
+            return freeBotModel(GLfloatVec);
         }
 
         attr = root->first_attribute("numParts");
         if(attr == NULL) {
             cerr << "number of parts in object not given" << endl;
-            exit(1);
+            return freeBotModel(GLfloatVec);
         }
         GLsizei numParts = (GLsizei)atoi(attr->value());
         cout << "number of parts: " << numParts << endl;
@@ -148,20 +375,25 @@ namespace objParse {
             part = root->first_node("part");
             if(part == NULL) {
                 cerr << "'part' tag missing" << endl;
-                exit(1);
+                return freeBotModel(GLfloatVec);
             }
         } else {
             cerr << "minimum one part per object" << endl;
-            exit(1);
+            return freeBotModel(GLfloatVec);
         }
 
         // part is pointing to first 'part' tag
         for(GLsizei i = 0; i < numParts; i++) {
 
+            if(part == NULL) {
+                cerr << "fewer 'part' tags than numParts" << endl;
+                return freeBotModel(GLfloatVec);
+            }
+
             rapidxml::xml_node<>* rect = part->first_node("rect");
             if(rect == NULL) {
                 cerr << "no rect vertices defined" << endl;
-                exit(1);
+                return freeBotModel(GLfloatVec);
             }
 
             // iterate through all 'rect' tags
@@ -179,20 +411,26 @@ namespace objParse {
                         int numV = 0;
                         do {
 
+                            if(numV == 4) {
+                                cerr << "more than 4 vertices in rect" << endl;
+                                delete myquad;
+                                return freeBotModel(GLfloatVec);
+                            }
+
                             rapidxml::xml_attribute<>* attrVertex = vertex->first_attribute("x");
                             if(attrVertex != NULL) {
                                 // x attribute exists
-                                myquad->pts[numV].x_ = (GLfloat)atof(attrVertex->value()) / _SCALE_;
+                                myquad->pts[numV].x_ = (GLfloat)atof(attrVertex->value());
                             }
                             attrVertex = vertex->first_attribute("y");
                             if(attrVertex != NULL) {
                                 // y attribute exists
-                                myquad->pts[numV].y_ = (GLfloat)atof(attrVertex->value()) / _SCALE_;
+                                myquad->pts[numV].y_ = (GLfloat)atof(attrVertex->value());
                             }
                             attrVertex = vertex->first_attribute("z");
                             if(attrVertex != NULL) {
                                 // z attribute exists
-                                myquad->pts[numV].z_ = (GLfloat)atof(attrVertex->value()) / _SCALE_;
+                                myquad->pts[numV].z_ = (GLfloat)atof(attrVertex->value());
                             }
 
                             numV++;
@@ -203,21 +441,21 @@ namespace objParse {
                         if(shift != NULL) {
                             rapidxml::xml_attribute<>* attrShift = shift->first_attribute("x");
                             if(attrShift != NULL) {
-                                GLfloat xshift = (GLfloat)atof(attrShift->value()) / _SCALE_;
+                                GLfloat xshift = (GLfloat)atof(attrShift->value());
                                 for(int i = 0; i < 4; i++) {
                                     myquad->pts[i].x_ += xshift;
                                 }
                             }
                             attrShift = shift->first_attribute("y");
                             if(attrShift != NULL) {
-                                GLfloat yshift = (GLfloat)atof(attrShift->value()) / _SCALE_;
+                                GLfloat yshift = (GLfloat)atof(attrShift->value());
                                 for(int i = 0; i < 4; i++) {
                                     myquad->pts[i].y_ += yshift;
                                 }
                             }
                             attrShift = shift->first_attribute("z");
                             if(attrShift != NULL) {
-                                GLfloat zshift = (GLfloat)atof(attrShift->value()) / _SCALE_;
+                                GLfloat zshift = (GLfloat)atof(attrShift->value());
                                 for(int i = 0; i < 4; i++) {
                                     myquad->pts[i].z_ += zshift;
                                 }
@@ -225,7 +463,8 @@ namespace objParse {
 
                         } else {
                             cerr << "shifted values not given" << endl;
-                            exit(1);
+                            delete myquad;
+                            return freeBotModel(GLfloatVec);
                         }
 
                         // get rgb color information for the rectangle
@@ -249,17 +488,20 @@ namespace objParse {
 
                             } else {
                                 cerr << "one or more rgb values missing" << endl;
-                                exit(1);
+                                delete myquad;
+                                return freeBotModel(GLfloatVec);
                             }
                         } else {
                             cerr << "color information not given" << endl;
-                            exit(1);
+                            delete myquad;
+                            return freeBotModel(GLfloatVec);
                         }
 
                         GLfloatVec->push_back(myquad);
                     } else {
                         cerr << "Vertices not given" << endl;
-                        exit(1);
+                        delete myquad;
+                        return freeBotModel(GLfloatVec);
                     }
 
 
@@ -270,7 +512,7 @@ namespace objParse {
                     cout << "reusing rect: " << attr->value() << endl;
 
                     // copy correct rectangle information into new rectangle struct
-                    Quadfloat3* usesOld;
+                    Quadfloat3* usesOld = NULL;
                     for(int i = 0; i < GLfloatVec->size(); i++) {
                         if(strcmp(GLfloatVec->at(i)->name, attr->value()) == 0) {
                             cout << "original found at index " << i << endl;
@@ -279,6 +521,11 @@ namespace objParse {
                         }
                     }
 
+                    if(usesOld == NULL) {
+                        cerr << "rect to reuse not found: " << attr->value() << endl;
+                        return freeBotModel(GLfloatVec);
+                    }
+
                     rapidxml::xml_node<>* shift = rect->first_node("shift");
                     if(shift != NULL) {
 
@@ -289,19 +536,21 @@ namespace objParse {
                         if(attrShiftX && attrShiftY && attrShiftZ) {
 
                             for(int i = 0; i < 4; i++) {
-                                usesOld->pts[i].x_ += (GLfloat)atof(attrShiftX->value()) / _SCALE_;
-                                usesOld->pts[i].y_ += (GLfloat)atof(attrShiftY->value()) / _SCALE_;
-                                usesOld->pts[i].z_ += (GLfloat)atof(attrShiftZ->value()) / _SCALE_;
+                                usesOld->pts[i].x_ += (GLfloat)atof(attrShiftX->value());
+                                usesOld->pts[i].y_ += (GLfloat)atof(attrShiftY->value());
+                                usesOld->pts[i].z_ += (GLfloat)atof(attrShiftZ->value());
                             }
 
                         } else {
                             cerr << "shift value missing" << endl;
-                            exit(1);
+                            delete usesOld;
+                            return freeBotModel(GLfloatVec);
                         }
 
                     } else {
                         cerr << "shift not given for copy" << endl;
-                        exit(1);
+                        delete usesOld;
+                        return freeBotModel(GLfloatVec);
                     }
 
                     rapidxml::xml_node<>* color = rect->first_node("color");
@@ -322,7 +571,8 @@ namespace objParse {
 
                         } else {
                             cerr << "one or more rgb values missing" << endl;
-                            exit(1);
+                            delete usesOld;
+                            return freeBotModel(GLfloatVec);
                         }
                     } else {
                         cout << "warning: color not given for cold rect" << endl;
@@ -338,14 +588,24 @@ namespace objParse {
 
         }
 
-        // invert every x-coordinate, seems that GLUT/OpenGL doesn't like the human view of the world
-        for(unsigned int i = 0; i < GLfloatVec->size(); i++) {
-            for(int j = 0; j < 4; j++) {
-                GLfloatVec->at(i)->pts[j].x_ *= -1;
-            }
-        }
+        // scale everything and invert every x-coordinate in one pass, seems that GLUT/OpenGL doesn't like the human view of the world
+        // (corner order is left alone so wireframes look the same as before)
+        transformModel(GLfloatVec, scaleMatrix(-1.0f / scale, 1.0f / scale, 1.0f / scale), 0, false);
+
+        return GLfloatVec;
+    }
+
+    /* same as loadBotModel but exits if the file cant be parsed */
+    Model* parseBotModel(char* filename, GLfloat scale = _SCALE_) {
+        Model* GLfloatVec = loadBotModel(filename, scale);
+        if(GLfloatVec == NULL)
+            exit(1);
+        return GLfloatVec;
+    }
 
-        return;
+    /* parses xml file containing physical description of robot into the global GLfloatVec */
+    void parseBotFile(char* filename, GLfloat scale = _SCALE_) { // expects Model to be empty
+        GLfloatVec = parseBotModel(filename, scale);
     }
 
     /* returns a model of the robot in its original position */
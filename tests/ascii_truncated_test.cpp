@@ -0,0 +1,141 @@
+/*
+    ascii_truncated_test, checks that cut off ascii .stl files still parse and never hang
+    Copyright (C) 2026  STL-Parser contributors
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Author(s):
+        STL-Parser contributors
+
+    File Type: test, STL-Parser
+
+    Date Created: 10/18/2026
+
+    Date Last Modified: 10/18/2026
+
+    Purpose:
+        Feeds parseStreamAscii / parseFileAscii files that stop part way through a facet, with and without
+        a trailing newline (a half finished save), and checks they return the facets that were there
+        instead of looping forever. An alarm kills the test if the parser hangs
+
+    Build and run (from the repository root, rapidxml headers on the include path for objectParser.hpp):
+        g++ -O2 -std=c++11 -pthread -I. -I/path/to/rapidxml tests/ascii_truncated_test.cpp -o ascii_truncated_test -lGL && ./ascii_truncated_test
+    Exits with 0 when every check passes
+
+*/
+
+#include <STL-Parser.hpp>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include <string>
+#include <sstream>
+
+using namespace stl;
+
+int numFailed = 0;
+
+void check(bool passed, const char* what) {
+    printf("%s: %s\n", passed ? "PASS" : "FAIL", what);
+    if(!passed)
+        numFailed++;
+}
+
+void onTimeout(int) {
+    const char message[] = "FAIL: parser did not return (hang)\n";
+    write(1, message, sizeof(message) - 1);
+    _exit(1);
+}
+
+const char* FULL_FACET =
+    "facet normal 0 0 1\n"
+    "  outer loop\n"
+    "    vertex 0 0 0\n"
+    "    vertex 1 0 0\n"
+    "    vertex 0 1 0\n"
+    "  endloop\n"
+    "endfacet\n";
+
+/* parses text from memory, returns the number of facets (-1 if checkFirst and the first facet isnt the expected triangle) */
+int parseText(const std::string& text, bool checkFirst = true) {
+    std::istringstream stream(text);
+    Model* myModel = parseStreamAscii(stream);
+    int numFacets = myModel->size();
+
+    if(checkFirst && numFacets > 0) {
+        triFloat3* tf3 = myModel->at(0);
+        if(tf3->pts[1].x_ != 1.0f || tf3->pts[2].y_ != 1.0f || tf3->normal.z_ != 1.0f)
+            numFacets = -1;
+    }
+
+    freeModel(myModel);
+    return numFacets;
+}
+
+void testTruncated(void) {
+    // cut off after the last vertex, the case from a save that was interrupted
+    std::string cut = "solid x\nfacet normal 0 0 1\nouter loop\nvertex 0 0 0\nvertex 1 0 0\nvertex 0 1 0";
+    check(parseText(cut) == 1, "facet without endloop/endfacet and no trailing newline");
+    check(parseText(cut + "\n") == 1, "facet without endloop/endfacet and a trailing newline");
+
+    check(parseText("solid x\nfacet normal 0 0 1\nouter loop\nvertex 0 0 0\nvertex 1 0 0\nvertex 0 1 0\nendloop") == 1,
+            "facet without endfacet and no trailing newline");
+    check(parseText("solid x\nfacet normal 0 0 1\nouter loop\nvertex 0 0", false) == 1,
+            "file cut off in the middle of a vertex");
+    check(parseText("solid x\nfacet normal 0 0", false) == 1, "file cut off in the middle of the normal");
+
+    check(parseText(std::string("solid x\n") + FULL_FACET + "facet normal 0 0 1\nouter loop\nvertex 0 0 0") == 2,
+            "complete facet followed by a cut off one");
+    check(parseText(std::string("solid x\n") + FULL_FACET + "endsolid x") == 1, "endsolid without a trailing newline");
+    check(parseText(std::string("solid x\n") + FULL_FACET + FULL_FACET + "endsolid x\n") == 2, "well formed file");
+
+    // a facet missing its end must not swallow the next facet
+    check(parseText(std::string("solid x\nfacet normal 0 0 1\nouter loop\nvertex 0 0 0\nvertex 1 0 0\nvertex 0 1 0\n") + FULL_FACET) == 2,
+            "facet missing its end followed by a complete facet");
+}
+
+void testTruncatedFile(const std::string& dir) {
+    std::string path = dir + "/cut.stl";
+    FILE* ofile = fopen(path.c_str(), "wb");
+    fputs("solid x\nfacet normal 0 0 1\nouter loop\nvertex 0 0 0\nvertex 1 0 0\nvertex 0 1 0", ofile);
+    fclose(ofile);
+
+    openFile((char*)path.c_str());
+    Model* myModel = parseFileAscii();
+    check(myModel->size() == 1, "parseFileAscii on a file cut off without a trailing newline");
+    freeModel(myModel);
+
+    remove(path.c_str());
+}
+
+int main(void) {
+    signal(SIGALRM, onTimeout);
+    alarm(10);
+
+    char dir[] = "/tmp/ascii_truncated_test_XXXXXX";
+    if(mkdtemp(dir) == NULL) {
+        std::cerr << "Cannot make a temporary directory" << std::endl;
+        return 1;
+    }
+
+    testTruncated();
+    testTruncatedFile(dir);
+
+    rmdir(dir);
+
+    printf("%d check(s) failed\n", numFailed);
+    return (numFailed == 0) ? 0 : 1;
+}
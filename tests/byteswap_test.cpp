@@ -0,0 +1,193 @@
+/*
+    byteswap_test, checks the big endian record conversion of STL-Parser on any machine
+    Copyright (C) 2026  STL-Parser contributors
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Author(s):
+        STL-Parser contributors
+
+    File Type: test, STL-Parser
+
+    Date Created: 10/18/2026
+
+    Date Last Modified: 10/18/2026
+
+    Purpose:
+        Forces the byte swapping path (STL_FORCE_BYTESWAP) so it runs on little endian x86 too, then checks
+        swapWords32 against a byte by byte reference (odd lengths, unaligned, in place), that binary files
+        round trip exactly through writeFileBinary / parseFileBinary, that the records on disk really are
+        swapped, and that ascii and binary copies of a mesh still hash the same
+
+    Build and run (from the repository root, rapidxml headers on the include path for objectParser.hpp),
+    once with the SIMD shuffle and once with the scalar fallback:
+        g++ -O2 -std=c++11 -pthread -mssse3 -DSTL_FORCE_BYTESWAP -I. -I/path/to/rapidxml tests/byteswap_test.cpp -o byteswap_test -lGL && ./byteswap_test
+        g++ -O2 -std=c++11 -pthread -mno-sse3 -DSTL_FORCE_BYTESWAP -I. -I/path/to/rapidxml tests/byteswap_test.cpp -o byteswap_test -lGL && ./byteswap_test
+    Exits with 0 when every check passes
+
+*/
+
+// the point of this test is the swap path, so force it even if the flag was left off
+#ifndef STL_FORCE_BYTESWAP
+#define STL_FORCE_BYTESWAP
+#endif
+
+#include <STL-Parser.hpp>
+#include <STL-Writer.hpp>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+using namespace stl;
+
+int numFailed = 0;
+
+void check(bool passed, const char* what) {
+    printf("%s: %s\n", passed ? "PASS" : "FAIL", what);
+    if(!passed)
+        numFailed++;
+}
+
+// small deterministic generator so the test doesnt depend on the platform rand()
+unsigned int nextRandom(unsigned int* state) {
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 8;
+}
+
+void testSwapWords(void) {
+    unsigned int state = 1;
+    std::vector<char> src(4 * 40 + 8);
+    for(unsigned int i = 0; i < src.size(); i++)
+        src[i] = (char)nextRandom(&state);
+
+    bool ok = true;
+
+    // every length that exercises the 16 byte groups plus a tail, at every alignment
+    for(size_t numWords = 0; numWords <= 40; numWords++) {
+        for(size_t offset = 0; offset < 4; offset++) {
+            std::vector<char> dst(src.size(), 0);
+            swapWords32(&src[offset], &dst[offset], numWords);
+            for(size_t w = 0; w < numWords; w++)
+                for(int b = 0; b < 4; b++)
+                    ok = ok && dst[offset + w * 4 + b] == src[offset + w * 4 + 3 - b];
+        }
+    }
+    check(ok, "swapWords32 matches byte reversal for 0-40 words at offsets 0-3");
+
+    std::vector<char> inPlace(src);
+    swapWords32(&inPlace[1], &inPlace[1], 37);
+    ok = inPlace[0] == src[0];
+    for(size_t w = 0; w < 37; w++)
+        for(int b = 0; b < 4; b++)
+            ok = ok && inPlace[1 + w * 4 + b] == src[1 + w * 4 + 3 - b];
+    for(size_t i = 1 + 37 * 4; i < src.size(); i++)
+        ok = ok && inPlace[i] == src[i];
+    check(ok, "swapWords32 in place on an unaligned buffer leaves the bytes around it alone");
+
+    char count[4];
+    writeLittleEndian32(count, 0x12345678u);
+    check(count[0] == 0x78 && count[1] == 0x56 && count[2] == 0x34 && count[3] == 0x12 && readLittleEndian32(count) == 0x12345678u,
+            "facet count is little endian whatever the host");
+}
+
+Model* makeModel(unsigned int numFacets) {
+    unsigned int state = 7;
+    Model* myModel = new Model;
+    for(unsigned int i = 0; i < numFacets; i++) {
+        triFloat3* tf3 = new triFloat3;
+        GLfloat* values = &tf3->pts[0].x_;
+        for(int k = 0; k < 9; k++)
+            values[k] = ((GLfloat)(nextRandom(&state) % 200001) - 100000.0f) / 997.0f;
+        tf3->normal.x_ = (GLfloat)(i % 3) - 1.0f;
+        tf3->normal.y_ = -0.0f;
+        tf3->normal.z_ = 1.0f / (GLfloat)(i + 1);
+        tf3->r_ = tf3->g_ = tf3->b_ = 0.0f;
+        myModel->push_back(tf3);
+    }
+    return myModel;
+}
+
+bool sameFacets(Model* a, Model* b) {
+    if(a->size() != b->size())
+        return false;
+    for(unsigned int i = 0; i < a->size(); i++) {
+        if(memcmp(a->at(i)->pts, b->at(i)->pts, sizeof(a->at(i)->pts)) != 0)
+            return false;
+        if(memcmp(&a->at(i)->normal, &b->at(i)->normal, sizeof(a->at(i)->normal)) != 0)
+            return false;
+    }
+    return true;
+}
+
+void testRoundTrip(const std::string& dir) {
+    check(STL_SWAP_BYTES == 1, "swap path is compiled in");
+
+    Model* myModel = makeModel(5001); // not a multiple of the parser or writer block sizes
+    std::string binaryPath = dir + "/model.stl";
+    std::string asciiPath = dir + "/model_ascii.stl";
+
+    check(writeFileBinary(myModel, binaryPath.c_str()), "writeFileBinary");
+    check(writeFileAscii(myModel, asciiPath.c_str()), "writeFileAscii");
+
+    unsigned long long binaryHash;
+    unsigned long long asciiHash;
+
+    openFile((char*)binaryPath.c_str());
+    Model* binaryModel = parseFileBinary(&binaryHash);
+    check(sameFacets(myModel, binaryModel), "binary write/read round trip is bit exact");
+
+    openFile((char*)asciiPath.c_str());
+    Model* asciiModel = parseFileAscii(&asciiHash);
+    check(sameFacets(myModel, asciiModel), "ascii write/read round trip is bit exact");
+    check(asciiHash == binaryHash, "ascii and binary copies hash the same");
+
+    // with the swap forced the records on disk are the native floats byte reversed
+    std::vector<char> buffer;
+    readFileBuffer((char*)binaryPath.c_str(), &buffer);
+    bool swapped = buffer.size() == 84 + 50 * myModel->size() && readLittleEndian32(&buffer[80]) == myModel->size();
+    for(unsigned int i = 0; swapped && i < myModel->size(); i++) {
+        char expected[48];
+        memcpy(expected, &myModel->at(i)->normal, 12);
+        memcpy(expected + 12, myModel->at(i)->pts, 36);
+        for(int w = 0; w < 12; w++)
+            for(int b = 0; b < 4; b++)
+                swapped = swapped && buffer[84 + i * 50 + w * 4 + b] == expected[w * 4 + 3 - b];
+    }
+    check(swapped, "binary records on disk are byte swapped");
+
+    freeModel(myModel);
+    freeModel(binaryModel);
+    freeModel(asciiModel);
+    remove(binaryPath.c_str());
+    remove(asciiPath.c_str());
+}
+
+int main(void) {
+    char dir[] = "/tmp/byteswap_test_XXXXXX";
+    if(mkdtemp(dir) == NULL) {
+        std::cerr << "Cannot make a temporary directory" << std::endl;
+        return 1;
+    }
+
+    testSwapWords();
+    testRoundTrip(dir);
+
+    rmdir(dir);
+
+    printf("%d check(s) failed\n", numFailed);
+    return (numFailed == 0) ? 0 : 1;
+}